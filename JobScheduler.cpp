@@ -1,964 +1,4150 @@
-#include <cmath>
-#include <cstdio>
-#include <vector>
-#include <iostream>
-#include<bits/stdc++.h>
-#include <algorithm>
-#include<string>
-#define ll unsigned long long
-using namespace std;
-
-/*
-USER DEFINED STRUCTURES
-(a) Job
-Stores all information about a job, that is the timestamp,processID,originSystem,instruction,importance and duration
-along with a few introduced variables:
- - ID   : SNo. of the job based on the order that it comes in. Uniquely identifies a job.
- - qExit: Time when job leaves the queue i.e. when a CPU is allotted to it
-
-(b) MaxMinNode
-Used to store the maximum and minimum timestamp across jobs waiting in the queue at a particular timestamp.
-Used to reduce search space while querying (Explained later)
-
-(c) CPUNode
-Node for a height-balanced BST tree (AVL Tree). This may contain the same value multiple times and this is tracked
-using the frequency variable.
-
-STL CONTAINER USED:
-(a) Vector
-
-ALGORITHM OUTLINE:
-Part 1: 'job' and 'assign'
-Objective here is to be able to store incoming jobs in such a way that the max priority job can be fetched
-efficiently during 'assign'. Moreover, we need to keep track of CPU's to which jobs can be assigned at any given time.
-
-The former is achieved by using a max-heap based priority queue (PQ). Whenever a job comes in we simply insert into the heap and at the time of assignment we simply extract the max priority job.
-
-Now to find the number of CPU's that are available at a given time T, it is enough to find the number of CPU's
-that get free at any time t ( <= T) (assuming that a new job can be scheduled as soon as the CPU gets free)
-To achieve this, we have used a height balanced BST  (AVL Tree). 
-
-Let's call the time after which a CPU gets free as freeAfter.
-Inititally all CPU's have freeAfter set to 0 (because timestamp >= 0).
-
-To find number of CPU's availble at time T we query the number of values in BST that are less than or equal to T. This is done in logarithimic time. Then, for every job to be assigned, we delete a node with minimum freeAfter value and insert
-a new node with freeAfter value set to (T + Duration Of Job)
-
-Also while assigning a job to the CPU, we update it's qExti value to the current timestamp.
-Note that each job is inserted into a job list so that all information of a job can be directly accessed once we have
-it's ID.
-
-Complexity:
-'job'   : O(logN)
-'assign': O(logM)
-N: Number of jobs present in queue at the moment
-M: Number of CPU's
-
-Part 2: 'query'
-Here we need to print in decreasing order of priority all jobs that were waiting in queue at a particular time T
-in history.
-Firstly note that if we have got 'job' and 'assign' commands at times T(1), T(2) T(3), ... etc. then querying for time T
-where T(i) <= T < T(i+1) is equivalent to querying for T(i).
-The naive way to do this is to store the state of the job heap at every timestamp and while querying simply extract
-the required number of jobs and print. But obviously, this will blow up the memory.
-
-The other way is to go through all the jobs in history and check for jobs that have timestamp <= T and T < qExit as
-these are jobs that were residing in the queue at time T. Once we get these jobs we build a heap on top of them and then extract the desired number of highest priority jobs.
-
-
-The main components that consume time here are:
- - Searching all jobs in history
- - Building a heap for each query
- 
-Note that we have all the jobs stored in increasing order of timestamp. So at each timestamp instead of storing the entire queue we store the maximum and minimum value of timestamp for jobs in the queue at that moment.
-This way when we make a query we only have to search for jobs whose timestamps lie in this range and this can be found directly with a binary search routine. 
-This is helpful as for a large timestamp query it is likely that we might not need to look at jobs with a very small timestamp.
-
-The next bottle-neck is the construct of heap for every query. To avoid this we store the jobs in an ordering based on priority so that we can scan through them in decreasing order of priority.
-
-For this, we use the fact that there are only 100 distinct importance levels. We first bucket all jobs based on this. Also within this bucket all the jobs are in increasing order of timestamps. The only ambiguity is for jobs with the same timestamp and bucket but different durations. To handle this we keep a seperate priority queue for each importance bucket so that we insert jobs with same timestamps in increasing order of duration.
-This way once we enter into a bucket, all jobs here are in decreasing order of priority.
-
-So finally, given a query for time T we start visiting these buckets in decreasing order of importance and scan through them linearly till we get the required number of jobs. No heap construction is requried now.
- 
-COMPLEXITY:
-Worst Case: O(N)
-But since jobs will be distributed across prioritites and we are significantly reducing our search space using the
-min/max values we get good average running times
-
-
-Note that a partition based on 'origin' was also tried, but that gave us higher running time on the given test cases as so that approach was dropped.
-
-
-OPTIMIZATIONS AND DESGIN CHOICES:
-(a) Firstly since the number of distinct importance levels was 100, we partitioned our jobHeaps based on this so that the heaps that we perform operations on are 100 times smaller at times of 'assign' and 'delete' (assuming a uniform distribution of jobs across all importance levels)
-
-(b) Instead of making a heap where each node corresponds to a Job instance we have used the jobID as the heap variable. This is more efficient as we avoid copying all the satellite data between nodes duing heapify and extract operations.
-Also, accessing the job information using ID is O(1).
-
-(c) To store the freeAfter times of CPU's we have used a BST, but a min-heap would also have done the job. But a BST is more efficient because here we are storing the frequency of a value as well in a node, this makes the size of tree smaller when there are multiple CPU's with the same freeAfter time. This improves both time and memory.
-eg. Initially when all M CPU's have freeAfter 0. Instread of creating a heap with M entries all equal to 0, our BST stores a single node with value 0 and frequency M.
-
-(d) While deleting a value from the BST, we can delete a CPUNode with freeAfter less than the given T. We could have deleted the root if it's value was less but we avoided doing so as it would involve finding the in-order sucessor in the right subtree and calling delete on that which would involve more recursions and would be less efficient.
-
-(e) A standard binary heap was chosen over a k-ary heap as k-ary heaps improve insertion / deletion times but increase the time to extract max values. Since this problem heavily uses the extractMax operation, k-ary heap was not a suitable choice.
-
-MEMORY
-jobList stores information for all jobs once. O(N)
-qJobList simply stores the ID's of all jobs once. 
-Similarly our priority queues store JobID rather than the complete information of jobs which makes it efficient in terms of memory.
-
-SOME THINGS WE MISSED
-The process of finding free CPU's can be optimzed further. Once we reach time T, all CPU's with freeAfter <= T are equivalent for us and so the tree can be pruned by merging all these into a single node, reducing the tree size.
-This however will not leave the tree balanced and a custom balancing routine needs to be thought for it.
-
-Also to maintain our duration heaps we are flushing it into qJobList whenever we see a timestamp greater than a previously seen timestamp. While doing this, to avoid scanning through 100 buckets every time, we have maintained a totalSize variable so that when all the bucket heaps are empty we don't unnecessarily scan through them.
-*/
-
-
-
-// Class to store job information
-class Job
-{
-    public:
-    ll processID;
-    ll timestamp;
-    string originSystem;
-    string instruction;
-    ll importance;
-    ll duration;
-    ll qExit;
-    ll ID;
-    Job(){}
-    Job(ll ID,ll processID,ll timestamp,string originSystem,string instruction,ll importance,ll duration)
-    {
-        this->processID = processID;
-        this->timestamp = timestamp;
-        this->originSystem = originSystem;
-        this->instruction = instruction;
-        this->importance = importance;
-        this->duration = duration;
-        this->qExit = 0;
-        this->ID = ID;
-    }
-    void printDescription()
-    {
-        cout<<"job "<<timestamp<<" "<<processID<<" "<<originSystem<<" "<<instruction<<" "<<importance<<" "<<duration<<endl;
-    }
-    
-    
-};
-
-// Stores Max/Min Timestamp of a job residing in queue at
-// a particular timestamp
-struct MaxMinNode
-{
-    ll Max,Min;
-    ll timestamp;
-    MaxMinNode(){}
-    MaxMinNode(ll Min,ll Max,ll timestamp)
-    {
-        this->Max = Max;
-        this->Min = Min;
-        this->timestamp = timestamp;
-    }
-    void updateValues(ll value)
-    {
-        Max = max(Max,value);
-        Min = min(Min,value);
-    }
-};
-
-// BST Node to store time after which CPU is free
-class CPUNode
-{
-    public:
-    ll freeAfter;
-    ll subtreeSize;
-    ll freq;
-    int height;
-    CPUNode *left;
-    CPUNode *right;
-    CPUNode() {}
-    CPUNode(ll freeAfter,ll freq)
-    {
-        this->freeAfter = freeAfter;
-        this->left = this->right = NULL;
-        this->freq = freq;
-        this->height = 1;
-    }
-};
-
-
-// Maps Job ID to Job Class
-vector<Job> jobList;
-
-// Partition of jobs seen so far based on importance
-vector<ll> qJobList[101];
-vector<ll> durationHeaps[101];  // Heaps to store durations for jobs with same timestamp and importance
-ll prevTimestamps[101]; // Last seen timestamp by a duration heap
-ll durationHeapSize[101] = {0}; // Sizes of duration heaps
-ll totalSize = 0; //Total jobs pending to be inserted
-
-
-// Vector of MaxMinNodes, one for each timestamp seen so far
-vector<MaxMinNode> MaxMins;
-
-
-ll getLeft(ll pos)
-{
-    return (2*pos) + 1;
-}
-ll getRight(ll pos)
-{
-    return (2*pos) + 2;
-}
-ll getParent(ll pos)
-{
-    return ((pos-1)/2);
-}
-
-
-bool hasHigherPriority(ll jID1,ll jID2)
-{
-    Job j1 = jobList[jID1];
-    Job j2 = jobList[jID2];
-    if(j1.importance > j2.importance)
-        return true;
-    if(j1.importance < j2.importance)
-        return false;
-    if(j1.timestamp < j2.timestamp)
-        return true;
-    if(j1.timestamp > j2.timestamp)
-        return false;
-    if(j1.duration < j2.duration)
-         return true;
-    return false; // j2 has higher duration
-}
-
-bool containsAlphabet(string s)
-{
-    for(ll i=0,l=s.length(); i<l; i++)
-        if(isalpha(s[i]))
-            return true;
-    return false;
-}
-
-ll convertStringToLL(string s)
-{
-    ll l = s.length();
-    ll result = 0;
-    ll k;
-    for(ll i=0; i<l; ++i)
-    {
-        k = s[i] - '0';
-        result = (result * 10) + k;
-    }
-    return result;
-}
-
-
-void maxHeapify(vector<ll> &jobHeap,ll pos,ll jobHeapSize)
-{
-    ll maxPos = pos;
-    ll left = getLeft(pos);
-    ll right = getRight(pos);
-    
-    if(left < jobHeapSize && hasHigherPriority(jobHeap[left],jobHeap[maxPos]))
-        maxPos = left;
-    if(right < jobHeapSize && hasHigherPriority(jobHeap[right],jobHeap[maxPos]))
-        maxPos = right;
-    
-    if(maxPos != pos)
-    {
-        ll tempJobID = jobHeap[maxPos];
-        jobHeap[maxPos] = jobHeap[pos];
-        jobHeap[pos] = tempJobID;
-        maxHeapify(jobHeap,maxPos,jobHeapSize);
-    }
-    
-}
-
-void maxHeapify_Duration(vector<ll> &jobHeap,ll pos,ll jobHeapSize)
-{
-    ll maxPos = pos;
-    ll left = getLeft(pos);
-    ll right = getRight(pos);
-    
-    if(left < jobHeapSize && jobList[jobHeap[left]].duration < jobList[jobHeap[maxPos]].duration)
-        maxPos = left;
-    if(right < jobHeapSize && jobList[jobHeap[right]].duration < jobList[jobHeap[maxPos]].duration)
-        maxPos = right;
-    
-    if(maxPos != pos)
-    {
-        ll tempJobID = jobHeap[maxPos];
-        jobHeap[maxPos] = jobHeap[pos];
-        jobHeap[pos] = tempJobID;
-        maxHeapify_Duration(jobHeap,maxPos,jobHeapSize);
-    }
-    
-}
-
-ll extractNextJob(vector<ll> &jobHeap,ll &jobHeapSize)
-{
-    ll jobID = jobHeap[0];
-    
-    if(jobHeapSize == 1)
-    {
-        jobHeapSize = 0;
-        return jobID;
-    }
-    jobHeapSize--;
-    jobHeap[0] = jobHeap[jobHeapSize];
-    maxHeapify(jobHeap,0,jobHeapSize);
-    return jobID;
-}
-
-ll extractNextID(vector<ll> &jobHeap,ll &jobHeapSize)
-{
-    totalSize--;
-    ll jobID = jobHeap[0];
-    
-    if(jobHeapSize == 1)
-    {
-        jobHeapSize = 0;
-        return jobID;
-    }
-    jobHeapSize--;
-    jobHeap[0] = jobHeap[jobHeapSize];
-    maxHeapify_Duration(jobHeap,0,jobHeapSize);
-    return jobID;
-}
-
-void insertJobIntoHeap(ll jobID,vector<ll> &jobHeap,ll &jobHeapSize)
-{
-    if(jobHeapSize + 1 > jobHeap.size())
-        jobHeap.push_back(jobID);
-    else jobHeap[jobHeapSize] = jobID;
-    
-    ll pos = jobHeapSize;
-    jobHeapSize++;
-    
-    while(1)
-    {
-        if(pos == 0)
-            break;
-        ll parent = getParent(pos);
-        if(hasHigherPriority(jobHeap[pos],jobHeap[parent]))
-        {
-            jobHeap[pos] = jobHeap[parent];
-            jobHeap[parent] = jobID;
-            pos = parent;
-        }
-        else break;
-    }   
-}
-
-void insertIntoDurationHeap(ll jobID,vector<ll> &jobHeap,ll &jobHeapSize)
-{
-    totalSize++;
-    if(jobHeapSize + 1 > jobHeap.size())
-        jobHeap.push_back(jobID);
-    else jobHeap[jobHeapSize] = jobID;
-    
-    ll pos = jobHeapSize;
-    jobHeapSize++;
-    
-    while(1)
-    {
-        if(pos == 0)
-            break;
-        ll parent = getParent(pos);
-        if(jobList[jobHeap[pos]].duration < jobList[jobHeap[parent]].duration)
-        {
-            jobHeap[pos] = jobHeap[parent];
-            jobHeap[parent] = jobID;
-            pos = parent;
-        }
-        else break;
-    }   
-}
-
-
-void emptyOutDurationHeap(ll importance)
-{
-    if(durationHeapSize[importance] == 0)
-        return;
-    while(durationHeapSize[importance])
-    {
-        ll popID = extractNextID(durationHeaps[importance],durationHeapSize[importance]);
-        qJobList[importance].push_back(popID);
-    }
-}
-
-void emptyOutAllDurationHeaps()
-{
-    for(ll i=1; i<=100; i++)
-        emptyOutDurationHeap(i);
-}
-
-ll getSubtreeSize(CPUNode *cpuNode)
-{
-    if(cpuNode == NULL)
-        return 0;
-    return cpuNode->subtreeSize;
-}
-
-int getHeight(CPUNode *cpuNode)
-{
-    if(cpuNode == NULL)
-        return 0;
-    return cpuNode->height;
-}
-
-int getBalance(CPUNode *cpuNode)
-{
-    if(cpuNode == NULL)
-        return 0;
-    return getHeight(cpuNode->left) - getHeight(cpuNode->right);
-}
-
-CPUNode *rightRotate(CPUNode *y)
-{
-    CPUNode *x = y->left;
-    CPUNode *T2 = x->right;
- 
-    // Perform rotation
-    x->right = y;
-    y->left = T2;
- 
-    // Update heights
-    y->height = max(getHeight(y->left), getHeight(y->right))+1;
-    x->height = max(getHeight(x->left), getHeight(x->right))+1;
- 
-    y->subtreeSize = getSubtreeSize(y->left) + y->freq + getSubtreeSize(y->right);
-    x->subtreeSize = getSubtreeSize(x->left) + x->freq + getSubtreeSize(x->right);
-    // Return new root
-    return x;
-}
- 
-CPUNode *leftRotate(CPUNode *x)
-{
-    CPUNode *y = x->right;
-    CPUNode *T2 = y->left;
- 
-    // Perform rotation
-    y->left = x;
-    x->right = T2;
- 
-    //  Update heights
-    x->height = max(getHeight(x->left), getHeight(x->right))+1;
-    y->height = max(getHeight(y->left), getHeight(y->right))+1;
- 
-    x->subtreeSize = getSubtreeSize(x->left) + x->freq + getSubtreeSize(x->right);
-    y->subtreeSize = getSubtreeSize(y->left) + y->freq + getSubtreeSize(y->right);
-    
-    // Return new root
-    return y;
-}
-
-ll getMinimum(CPUNode *startTimeRoot)
-{
-    CPUNode *root = startTimeRoot;
-    while(root->left)
-        root = root->left;
-    return root->freeAfter;
-}
-ll getMaximum(CPUNode *startTimeRoot)
-{
-    CPUNode *root = startTimeRoot;
-    while(root->right)
-        root = root->right;
-    return root->freeAfter;
-}
-
-CPUNode* createBST(ll noOfCPU)
-{
-    CPUNode* root = NULL;
-    if(noOfCPU <= 0)
-        return root;
-    root = new CPUNode(0,noOfCPU);
-    root->subtreeSize = noOfCPU;
-    return root;
-}
-
-ll getValuesLessThanEqualTo(CPUNode *root,ll value)
-{
-    if(root == NULL)
-        return 0;
-    if(root->freeAfter <= value)
-            return getSubtreeSize(root->left) + root->freq + getValuesLessThanEqualTo(root->right,value);
-    return getValuesLessThanEqualTo(root->left,value);
-}
-
-CPUNode* deleteCPUNode(CPUNode *root,ll value)
-{
-    if(root == NULL)
-        return root;
-    if(root->freeAfter > value) //recurse on left
-        root->left = deleteCPUNode(root->left,value);
-    else if(root->left != NULL) //recurse on left
-        root->left = deleteCPUNode(root->left,value);
-    else if(root->freq > 1) //no recursion base case
-    {
-        root->subtreeSize = root->subtreeSize - 1;
-        root->freq = root->freq - 1;
-        return root;
-    }
-    else //delete current node
-    {
-        if(root->right == NULL)
-            return NULL;
-        *root = *(root->right);
-    }
-        
-    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
-    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
-    
-    int balance = getBalance(root);
-    
-    if(abs(balance) <= 1)
-        return root;
-    
-    if (balance > 1 && getBalance(root->left) >= 0)
-        return rightRotate(root);
- 
-    // Left Right Case
-    if (balance > 1 && getBalance(root->left) < 0)
-    {
-        root->left =  leftRotate(root->left);
-        return rightRotate(root);
-    }
- 
-    // Right Right Case
-    if (balance < -1 && getBalance(root->right) <= 0)
-        return leftRotate(root);
- 
-    // Right Left Case
-    if (balance < -1 && getBalance(root->right) > 0)
-    {
-        root->right = rightRotate(root->right);
-        return leftRotate(root);
-    }   
-    return root;
-}
-
-CPUNode* deleteCustom(CPUNode *root,ll value)
-{
-    if(root == NULL)
-        return root;
-    if(root->freeAfter > value) //recurse on left
-        root->left = deleteCustom(root->left,value);
-    else if(root->freeAfter < value) //recurse on left
-        root->right = deleteCustom(root->right,value);
-    else if(root->freq > 1) //no recursion base case
-    {
-        root->subtreeSize = root->subtreeSize - 1;
-        root->freq = root->freq - 1;
-        return root;
-    }
-    else //delete current node
-    {
-        if( (root->left == NULL) || (root->right == NULL) )
-        {
-            CPUNode *temp = root->left ? root->left : root->right;
-            // No child case
-            if(temp == NULL)
-            {
-                temp = root;
-                root = NULL;
-            }
-            else // One child case
-             *root = *temp;
-            free(temp);
-        }
-        else
-        {
-            ll temp = getMinimum(root->right);
-            root->freeAfter = temp;
-            root->right = deleteCustom(root->right, temp);
-        }
-    }
-        
-    if(root == NULL)
-        return NULL;
-    
-    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
-    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
-    
-    int balance = getBalance(root);
-    
-    if(abs(balance) <= 1)
-        return root;
-    
-    if (balance > 1 && getBalance(root->left) >= 0)
-        return rightRotate(root);
- 
-    // Left Right Case
-    if (balance > 1 && getBalance(root->left) < 0)
-    {
-        root->left =  leftRotate(root->left);
-        return rightRotate(root);
-    }
- 
-    // Right Right Case
-    if (balance < -1 && getBalance(root->right) <= 0)
-        return leftRotate(root);
- 
-    // Right Left Case
-    if (balance < -1 && getBalance(root->right) > 0)
-    {
-        root->right = rightRotate(root->right);
-        return leftRotate(root);
-    }   
-    return root;
-}
-
-
-CPUNode* insertCPUNode(CPUNode *root,ll value)
-{
-    if(root == NULL)
-    {
-        root = new CPUNode(value,1);
-        root->subtreeSize = 1;
-        return root;
-    }
-    if(root->freeAfter == value)
-    {
-        root->subtreeSize = root->subtreeSize + 1;
-        root->freq = root->freq + 1;
-        return root;
-    }
-    
-    if(root->freeAfter < value)
-        root->right = insertCPUNode(root->right,value);
-    else root->left = insertCPUNode(root->left,value);
-    
-    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
-    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
-    
-    int balance = getBalance(root);
-    if(abs(balance) <= 1)
-        return root;
-    // Left Left Case
-    if (balance > 1 && value < root->left->freeAfter)
-        return rightRotate(root);
- 
-    // Right Right Case
-    if (balance < -1 && value > root->right->freeAfter)
-        return leftRotate(root);
- 
-    // Left Right Case
-    if (balance > 1 && value > root->left->freeAfter)
-    {
-        root->left =  leftRotate(root->left);
-        return rightRotate(root);
-    }
- 
-    // Right Left Case
-    if (balance < -1 && value < root->right->freeAfter)
-    {
-        root->right = rightRotate(root->right);
-        return leftRotate(root);
-    }
-    
-    return root;
-}
-
-ll doBinarySearchMaxMins(ll timestamp,ll left,ll right)
-{
-    if(MaxMins[right].timestamp <= timestamp)
-        return right;
-    ll mid = (left + right)/2;
-    if(MaxMins[mid].timestamp <= timestamp)
-    {
-        if(MaxMins[mid+1].timestamp <= timestamp)
-                return doBinarySearchMaxMins(timestamp,mid+1,right);
-        return mid;
-    }
-    return doBinarySearchMaxMins(timestamp,left,mid-1);
-}
-
-ll getStartPoint(ll value,vector<ll> &jobIDVector,ll left,ll right)
-{
-    if(left == right)
-        return left;
-    ll mid = (left + right)/2;
-    if(jobList[jobIDVector[mid]].timestamp == value)
-        return getStartPoint(value,jobIDVector,left,mid);
-    if(jobList[jobIDVector[mid]].timestamp < value)
-        return getStartPoint(value,jobIDVector,mid+1,right);
-    if(mid != left)
-        return getStartPoint(value,jobIDVector,left,mid-1);
-    return left;
-}
-
-ll getEndPoint(ll value,vector<ll> &jobIDVector,ll left,ll right)
-{
-    if(left == right)
-        return left;
-    ll mid = (left + right)/2;
-    if(jobList[jobIDVector[mid]].timestamp == value)
-    {
-        if(jobList[jobIDVector[mid+1]].timestamp == value)
-             return getEndPoint(value,jobIDVector,mid+1,right);
-        else return mid;
-    }
-    if(jobList[jobIDVector[mid]].timestamp < value)
-    {
-        if(jobList[jobIDVector[mid+1]].timestamp > value)
-            return mid;
-        return getEndPoint(value,jobIDVector,mid+1,right);
-    }
-    return getEndPoint(value,jobIDVector,left,mid-1);
-}
-
-
-
-void printHistory_TOPK(ll timestamp,ll K)
-{
-    ll selected = 0;
-    int importance = 100;
-    ll tsNearbyIndex = doBinarySearchMaxMins(timestamp,0,MaxMins.size()-1);
-    ll Min = MaxMins[tsNearbyIndex].Min;
-    ll Max = MaxMins[tsNearbyIndex].Max;
-    if(Max < Min)
-        return;
-    
-    while(selected < K && importance != 0)
-    {
-        vector<ll> jobIDVector = qJobList[importance--];
-        if(jobIDVector.size() == 0)
-                continue;
-        
-        if(Max < jobList[jobIDVector[0]].timestamp)
-            continue;
-        if(Min > jobList[jobIDVector[jobIDVector.size()-1]].timestamp)
-            continue;
-        
-         ll left = getStartPoint(Min,jobIDVector,0,jobIDVector.size()-1);
-         ll right = getEndPoint(Max,jobIDVector,0,jobIDVector.size()-1);
-
-        for(ll j=left,l=right; j<=l; ++j)
-        {
-            ll jobID = jobIDVector[j];
-            Job job = jobList[jobID];
-            if(job.timestamp <= timestamp && (timestamp < job.qExit || job.qExit == 0))
-            {
-                job.printDescription();
-                selected++;
-            }
-            if(job.timestamp > timestamp || selected == K)
-                break;
-        }
-    }
-}
-
-void printHistory_Origin(ll timestamp,string origin)
-{
-    ll selected = 0;
-    int importance = 100;
-    ll tsNearbyIndex = doBinarySearchMaxMins(timestamp,0,MaxMins.size()-1);
-    ll Min = MaxMins[tsNearbyIndex].Min;
-    ll Max = MaxMins[tsNearbyIndex].Max;
-    
-    if(Max < Min)
-        return;
-    
-    while(importance != 0)
-    {
-        vector<ll> jobIDVector = qJobList[importance--];
-        if(jobIDVector.size() == 0)
-                continue;
-        
-        if(Max < jobList[jobIDVector[0]].timestamp)
-            continue;
-        if(Min > jobList[jobIDVector[jobIDVector.size()-1]].timestamp)
-            continue;
-        
-        ll left = getStartPoint(Min,jobIDVector,0,jobIDVector.size()-1);
-        ll right = getEndPoint(Max,jobIDVector,0,jobIDVector.size()-1);
-    
-        for(ll j=left,l=right; j<=l; ++j)
-        {
-            ll jobID = jobIDVector[j];
-            Job job = jobList[jobID];
-            if(job.timestamp <= timestamp && (timestamp < job.qExit || job.qExit == 0) && job.originSystem == origin)
-            {
-                job.printDescription();
-                selected++;
-            }
-            if(job.timestamp > timestamp)
-                break;
-        }
-    }
-}
-
-
-int main() {
-    /* Enter your code here. Read input from STDIN. Print output to STDOUT */   
-    char lineInput[5000];
-    string operation;
-    
-    ll noOfCPU;
-    ll processID,timestamp,duration,importance;
-    string originSystem,instruction;
-    ll K;
-    
-    // Priority Queue Of Jobs Waiting (partitioned on importance value)
-    vector<ll> jobHeap[101];
-    ll jobHeapSize[101] = {0};
-    
-    // Create BST To Store CPU Free Times
-    CPUNode *cpuTreeRoot;
-    
-    // Stores timestamps of jobs waiting in queue as a Priority Queue
-    CPUNode *startTimeRoot = NULL;
-    
-    ll ID = 0; //Dummmy Variable acting as ID
-    ll prevTimestamp; // last seen timestamp
-    
-    while(gets(lineInput))
-    {
-        stringstream ss(lineInput);
-        ss>>operation;
-        if(operation == "cpus")
-        {
-            ss>>noOfCPU;
-            cpuTreeRoot = createBST(noOfCPU); // Create root node of CPU BST Tree
-        }   
-        else if(operation == "job")
-        {
-            ss>>timestamp;
-            ss>>processID;
-            ss>>originSystem;
-            ss>>instruction;
-            ss>>importance;
-            ss>>duration;
-            
-            if(timestamp > prevTimestamp && totalSize > 0)
-                emptyOutAllDurationHeaps();
-            
-            prevTimestamp = timestamp;
-            
-            Job job = Job(ID,processID,timestamp,originSystem,instruction,importance,duration);
-            jobList.push_back(job);
-            insertJobIntoHeap(ID,jobHeap[importance],jobHeapSize[importance]);
-            
-            // Duration heap is empty
-            if(durationHeapSize[importance] == 0)
-            {
-                insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
-                prevTimestamps[importance] = timestamp;
-            }
-            // Alread some entries are present
-            else
-            {
-                if(prevTimestamps[importance] == timestamp)
-                    insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
-                else
-                {
-                    prevTimestamps[importance] = timestamp;
-                    emptyOutDurationHeap(importance);
-                    insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
-                }
-            }
-            
-            ID++;
-            
-            startTimeRoot = insertCPUNode(startTimeRoot,timestamp);
-            
-            if(MaxMins.size() == 0)
-                MaxMins.push_back(MaxMinNode(timestamp,timestamp,timestamp));
-            else if(MaxMins[MaxMins.size()-1].timestamp == timestamp)
-                MaxMins[MaxMins.size()-1].updateValues(timestamp);
-             else
-            {
-                ll Min = getMinimum(startTimeRoot);
-                ll Max = getMaximum(startTimeRoot);
-                MaxMins.push_back(MaxMinNode(Min,Max,timestamp));
-             }
-        }
-        else if(operation == "assign")
-        {
-            ss>>timestamp;
-            ss>>K;
-            
-            // No jobs with multiple timestamps less than this will be seen so flush the durationHeaps
-            if(totalSize > 0)
-                emptyOutAllDurationHeaps();
-            
-            // Get number of jobs to be assigned
-            ll freeCPU = getValuesLessThanEqualTo(cpuTreeRoot,timestamp);
-            
-            prevTimestamp = timestamp;
-            
-            
-            // Scan from 100 - 1 importance buckets to get the jobs to be assigned
-            K = min(freeCPU,K);
-            ll selected = 0;
-            importance = 100;
-            // Keep assigning till desired number is met
-            while(selected < K && importance != 0)
-            {
-                ll choose = K - selected;
-                ll newJobsToSchedule = min(choose,jobHeapSize[importance]);
-                if(newJobsToSchedule == 0)
-                {
-                    importance--;
-                    continue;
-                }
-                
-                for(ll i=0; i<newJobsToSchedule; ++i)
-                {
-                    ll nextJobID = extractNextJob(jobHeap[importance],jobHeapSize[importance]);
-                    jobList[nextJobID].printDescription();
-                    cpuTreeRoot = deleteCPUNode(cpuTreeRoot,timestamp);
-                    cpuTreeRoot = insertCPUNode(cpuTreeRoot,(timestamp + jobList[nextJobID].duration));
-                    jobList[ nextJobID ].qExit = timestamp;
-                    startTimeRoot = deleteCustom(startTimeRoot,jobList[nextJobID].timestamp);
-            
-                }
-                selected += newJobsToSchedule;
-                importance--;
-            }
-            
-            
-            // Updating the max-min values
-            ll Max,Min;
-            if(startTimeRoot == NULL)
-            {
-                Max = 0;
-                Min = 1;
-            }
-            else
-            {
-                Max = getMaximum(startTimeRoot);        
-                Min = getMinimum(startTimeRoot);
-            }
-
-            if(MaxMins[MaxMins.size()-1].timestamp == timestamp)
-                MaxMins[MaxMins.size()-1] = MaxMinNode(Min,Max,timestamp);
-            else MaxMins.push_back(MaxMinNode(Min,Max,timestamp));
-            
-        }
-        else if(operation == "query")
-        {
-            ss>>timestamp;
-            ss>>operation;
-            
-            // If timestamp is greater than earlier seen timestamp then flush out the durationHeaps
-            if(timestamp >= prevTimestamp && totalSize > 0)
-                emptyOutAllDurationHeaps();
-            
-            // Checks if string contains alphabet to distinguish the two query types
-            if(!containsAlphabet(operation))
-                printHistory_TOPK(timestamp,convertStringToLL(operation));
-            else
-                printHistory_Origin(timestamp,operation);
-        }
-    }
-    
-    return 0;
-}
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <iostream>
+#include<bits/stdc++.h>
+#include <algorithm>
+#include<string>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#define ll unsigned long long
+using namespace std;
+
+/*
+USER DEFINED STRUCTURES
+(a) Job
+Stores all information about a job, that is the timestamp,processID,originSystem,instruction,importance and duration
+along with a few introduced variables:
+ - ID   : SNo. of the job based on the order that it comes in. Uniquely identifies a job and is its position in
+          the job list, so it is not stored in the job.
+ - qExit: Time when job leaves the queue i.e. when a CPU is allotted to it
+The originSystem is stored as an index into a table of the distinct origins (NameTable) and the instruction, which is
+only ever printed back, as a pointer into a packed store of strings (StringArena), so a job takes 64 bytes (48 with
+32-bit keys) rather than carrying two std::strings.
+
+(b) MaxMinNode
+Used to store the maximum and minimum timestamp across jobs waiting in the queue at a particular timestamp.
+Used to reduce search space while querying (Explained later)
+
+(c) CPUNode
+Node for a height-balanced BST tree (AVL Tree). This may contain the same value multiple times and this is tracked
+using the frequency variable.
+
+(d) Scheduler
+Holds all the state below (job list, heaps, history buckets, CPU tree) and is a template over the type of job IDs,
+timestamps and durations, over the number of importance levels and over the job queue backend. Two widths are shipped:
+ - 64-bit IDs, timestamps and durations (default)
+ - 32-bit IDs, timestamps and durations. Timestamps are stored relative to the first timestamp seen
+   (the epoch) so only the span of the trace needs to fit in 32 bits.
+The narrow variant is selected with '--width=32' or with a width on the header line ("cpus <M> 32"). If a value does
+not fit, the program reports it on stderr and exits rather than silently truncating.
+Job::qExit uses the maximum value of the timestamp type to mark a job that is still waiting.
+
+STL CONTAINER USED:
+(a) Vector
+
+ALGORITHM OUTLINE:
+Part 1: 'job' and 'assign'
+Objective here is to be able to store incoming jobs in such a way that the max priority job can be fetched
+efficiently during 'assign'. Moreover, we need to keep track of CPU's to which jobs can be assigned at any given time.
+
+The former is achieved by using a max-heap based priority queue (PQ). Whenever a job comes in we simply insert into the heap and at the time of assignment we simply extract the max priority job.
+
+Now to find the number of CPU's that are available at a given time T, it is enough to find the number of CPU's
+that get free at any time t ( <= T) (assuming that a new job can be scheduled as soon as the CPU gets free)
+To achieve this, we have used a height balanced BST  (AVL Tree). 
+
+Let's call the time after which a CPU gets free as freeAfter.
+Inititally all CPU's have freeAfter set to 0 (because timestamp >= 0).
+
+To find number of CPU's availble at time T we query the number of values in BST that are less than or equal to T. This is done in logarithimic time. Then, for every job to be assigned, we delete a node with minimum freeAfter value and insert
+a new node with freeAfter value set to (T + Duration Of Job)
+
+Also while assigning a job to the CPU, we update it's qExti value to the current timestamp.
+Note that each job is inserted into a job list so that all information of a job can be directly accessed once we have
+it's ID.
+
+Complexity:
+'job'   : O(logN)
+'assign': O(logM)
+N: Number of jobs present in queue at the moment
+M: Number of CPU's
+
+'cancel <timestamp> <processID>' removes the waiting job submitted at that timestamp by that process. Waiting jobs are
+indexed by (processID, timestamp) in a hash map and every queue backend keeps the position of each job so it can be
+removed from the middle in O(logN) (amortized O(1) for '--heap=monotone', which leaves holes it compacts later).
+The job gets the last seen timestamp as its qExit, so history queries stop reporting it from then on, and it is
+removed from the tree of pending timestamps used for the max/min values.
+
+'reprioritize <timestamp> <processID> <importance>' moves a waiting job to another importance bucket through the same
+index. With '--age=<interval>' a waiting job is promoted by one importance level every <interval> time units; pending
+promotions are kept in a min-heap of due times and applied at the next 'job' or 'assign', so only the jobs that are due
+are touched. A reprioritize restarts the aging clock of the job.
+Aging is eager: every promotion moves the job between buckets and pushes its next due time, both O(logN), so a job
+waiting W time units costs O(min(W/interval,LEVELS) logN) on top of its own insert and extract. With deep queues and a
+small interval this dominates: on a 500k job trace from bench/gen_trace.py, whose queues grow to hundreds of thousands
+of jobs, the run takes 2.1s without aging, 2.3s with '--age=100000', 4.8s with '--age=10000' and 20s with '--age=1000'.
+Pick an interval that is long next to the usual wait of a job.
+
+With '--fair-share' waiting jobs are queued per originSystem instead of per importance, each origin's queue being the
+'--heap=' backend in the usual priority order ('monotone' is rejected, it relies on a queue holding one importance).
+'assign' takes jobs from the origins by deficit round robin: the origins with waiting jobs form a round, each gets
+'weight' jobs per turn ('weight <originSystem> <weight>', 1 by default) and an origin that runs out of jobs leaves the
+round and rejoins at its end. Picking the origin is amortized O(1) and the job O(logN), however many origins there
+are. History and queries are the same in both modes.
+
+'cpuquery <T>' prints how many CPUs were busy at T and when the first of them became free ("cpuquery T <busy> <time>",
+"none" if no CPU was busy). Every assign that starts jobs keeps a version of the CPU tree (CPUHistory): a persistent
+AVL tree where starting a job path-copies O(logM) nodes and shares the rest with the previous version, so a past T is
+answered in O(logM) from the last version at or before it. Nodes are reference counted and the oldest versions are
+dropped once the nodes and the list of versions take more than '--cpu-history=<MB>', counting the nodes as malloc
+hands them out (64 bytes each, 48 narrow); queries for a dropped time print "cpuquery T expired". The history is off
+unless '--cpu-history=' is given, and 'cpuquery' then prints "cpuquery T disabled".
+
+Part 2: 'query'
+Here we need to print in decreasing order of priority all jobs that were waiting in queue at a particular time T
+in history.
+Firstly note that if we have got 'job' and 'assign' commands at times T(1), T(2) T(3), ... etc. then querying for time T
+where T(i) <= T < T(i+1) is equivalent to querying for T(i).
+The naive way to do this is to store the state of the job heap at every timestamp and while querying simply extract
+the required number of jobs and print. But obviously, this will blow up the memory.
+
+The other way is to go through all the jobs in history and check for jobs that have timestamp <= T and T < qExit as
+these are jobs that were residing in the queue at time T. Once we get these jobs we build a heap on top of them and then extract the desired number of highest priority jobs.
+
+
+The main components that consume time here are:
+ - Searching all jobs in history
+ - Building a heap for each query
+ 
+Note that we have all the jobs stored in increasing order of timestamp. So at each timestamp instead of storing the entire queue we store the maximum and minimum value of timestamp for jobs in the queue at that moment.
+This way when we make a query we only have to search for jobs whose timestamps lie in this range and this can be found directly with a binary search routine. 
+This is helpful as for a large timestamp query it is likely that we might not need to look at jobs with a very small timestamp.
+
+The next bottle-neck is the construct of heap for every query. To avoid this we store the jobs in an ordering based on priority so that we can scan through them in decreasing order of priority.
+
+For this, we use the fact that there are only 100 distinct importance levels. We first bucket all jobs based on this. Also within this bucket all the jobs are in increasing order of timestamps. The only ambiguity is for jobs with the same timestamp and bucket but different durations. To handle this we keep a seperate priority queue for each importance bucket so that we insert jobs with same timestamps in increasing order of duration.
+This way once we enter into a bucket, all jobs here are in decreasing order of priority.
+
+So finally, given a query for time T we start visiting these buckets in decreasing order of importance and scan through them linearly till we get the required number of jobs. No heap construction is requried now.
+
+Each bucket (HistoryBucket) keeps its most recent entries uncompressed. Once BLOCK_SIZE entries accumulate they are
+sealed into a block: timestamps and job IDs are stored as varint deltas from the previous entry and a block header
+keeps the first entry, the min/max timestamp of the block, the latest qExit of its jobs and how many of them are still
+waiting. The start and end points of a query
+are found by binary searching the block headers and decoding only one block, and the scan decodes a block at a time,
+skipping blocks in which every job had left the queue by time T. A max-tree over the blocks of the time their last
+job left finds the next block with a job alive at T in O(logB), so runs of exited blocks cost nothing to step over
+however long they are. The unsealed tail is always scanned.
+Jobs that changed importance while waiting stay in the bucket they were submitted to until the first change
+(Job::bucketExit). After that they are kept as stays (from, until, importance at 'from'); one stay covers a whole
+aging run since the importance at T follows from the interval. Stays are indexed in groups that give the stays of
+one importance at T from at most two groups, each with a max-tree over 'until' that skips the stays closed by T.
+The bucket scan merges in the stays of each importance as it reaches it, in priority order, and stops at K.
+
+With '--offline' the whole trace is read first and the queries are answered afterwards, when every qExit is known.
+Each job's history is cut into segments (job, importance, [start, end)), the queries are sorted by T and a single
+sweep over time inserts and removes segments into a set of waiting jobs per importance bucket and per origin.
+A query then reads its answer straight off these sets, for O((N + Q)logN + output) overall however far back the
+query windows reach. Output is buffered and written in input order at the end.
+ 
+COMPLEXITY:
+Worst Case: O(N)
+But since jobs will be distributed across prioritites and we are significantly reducing our search space using the
+min/max values we get good average running times
+
+
+Note that a partition based on 'origin' was also tried, but that gave us higher running time on the given test cases as so that approach was dropped.
+
+
+OPTIMIZATIONS AND DESGIN CHOICES:
+(a) Firstly since the number of distinct importance levels was 100, we partitioned our jobHeaps based on this so that the heaps that we perform operations on are 100 times smaller at times of 'assign' and 'delete' (assuming a uniform distribution of jobs across all importance levels)
+
+(b) Instead of making a heap where each node corresponds to a Job instance we have used the jobID as the heap variable. This is more efficient as we avoid copying all the satellite data between nodes duing heapify and extract operations.
+Also, accessing the job information using ID is O(1).
+
+(c) To store the freeAfter times of CPU's we have used a BST, but a min-heap would also have done the job. But a BST is more efficient because here we are storing the frequency of a value as well in a node, this makes the size of tree smaller when there are multiple CPU's with the same freeAfter time. This improves both time and memory.
+eg. Initially when all M CPU's have freeAfter 0. Instread of creating a heap with M entries all equal to 0, our BST stores a single node with value 0 and frequency M.
+
+(d) While deleting a value from the BST, we can delete a CPUNode with freeAfter less than the given T. We could have deleted the root if it's value was less but we avoided doing so as it would involve finding the in-order sucessor in the right subtree and calling delete on that which would involve more recursions and would be less efficient.
+
+(e) The job queue is a template parameter of the Scheduler and '--heap=binary|4ary|pairing|monotone' selects an iterative binary heap, a 4-ary heap, a pairing heap or a monotone queue (see JOB QUEUE BACKENDS).
+bench/extract_k.sh builds the program and times the four backends on two generated traces (2M jobs over 100 levels with K=1, 1.5M jobs over 3 levels with K<=60); rerun it to compare them on another machine or with '--width=32'.
+It measured the 4-ary heap fastest on both, 4% and 10% ahead of the binary heap, despite the extra comparisons per extract: the shallower heap touches fewer cache lines. The pairing heap and the monotone queue were the slowest.
+The binary heap stays the default because the gap is about the size of the run-to-run noise of those runs and the traces are synthetic; switch the default if the gap holds on real traces.
+'assign' takes all the jobs it needs from a bucket with a single extractK call, which drains a bucket with one sort when every job in it is assigned.
+Jobs with the same importance, timestamp and duration are assigned in the order they came in, so all backends give the same output.
+
+MEMORY
+jobList stores information for all jobs once. O(N)
+It is kept in chunks (ChunkedList) backed by 2MB huge pages where available, each chunk holding as many jobs as fill
+its pages exactly. Chunks never move, so a new job never copies the earlier ones the way a growing vector did, and
+peak memory is not doubled during growth. With '--jobs=<N>' the chunks, the queue position array and the waiting index for N jobs are
+allocated on 'cpus', so no per-job structure grows while the trace is processed. The pages of the chunks are faulted
+in there as well, so storing a job does not take a page fault either.
+The queue position array, the aging times and the MaxMins array are chunked the same way.
+qJobList stores the ID's of all jobs once, delta-encoded in blocks (usually 2-3 bytes per job).
+Each job keeps its position in qJobList (historyPos, 8 bytes or 4 narrow) so the block it is in is found in O(1)
+when it leaves its bucket; finding it by timestamp instead decodes every block of jobs sharing that timestamp.
+Similarly our priority queues store JobID rather than the complete information of jobs which makes it efficient in terms of memory.
+With the narrow scheduler every heap entry, history entry and MaxMinNode is half the size, so twice as many fit in a
+cache line during heapify and history scans. A job itself only shrinks from 64 to 48 bytes since the processID and
+the instruction pointer stay 64-bit; on a 1.5M job trace peak memory goes from 220MB to 168MB, about a quarter less
+rather than half, the rest being the hash map of waiting jobs and the CPU and timestamp trees.
+
+LOW-JITTER MODE
+With '--jitter-budget=<N>' work that used to pile up and run in one go is spread over the following commands, at most
+N entries per 'job' or 'assign':
+ - a duration heap closed by a later timestamp is handed over in O(1) and moved into qJobList a slice at a time
+   (a query first finishes whatever is pending, since it has to see all of history)
+ - when the waiting index fills up, new entries go to a larger table and the old ones are moved over a slice at a
+   time instead of being rehashed all at once; the move gets half of N per command however many heaps are pending,
+   and the table is sized for the old entries plus every job that can come in before the move is done
+'--latency' prints the p50/p99/p99.9/max time per command on stderr to compare the two modes on a trace.
+'--latency-baseline=<file>' also compares them with a run recorded in the file (recording this run if there is none)
+and exits with status 1 when p50, p99 or p99.9 is more than '--latency-tolerance=<percent>' (10) above it.
+With '--profile' the latencies include the cost of its timers, so compare them with a baseline recorded the same way.
+bench/latency.sh runs this check on a generated bursty trace (jobs arriving 20000 at a time) with '--jitter-budget=64',
+recording the baseline on its first run. There the mode cuts the worst command from about 90ms to 6ms, at the cost of
+a higher p99 (about 27us against 8us) since most 'job' and 'assign' commands now carry a slice of deferred work.
+Growth that is still done in one go, inside a single command, in this mode:
+ - a new chunk of jobList (and of the other chunked lists) is mapped and faulted in, unless '--jobs=' preallocated it
+ - the larger waiting index table is allocated when the old one fills up (only the move is sliced)
+ - the vectors of the d-ary heaps (DaryJobHeap::jobHeap), the pairing heap node pool and the monotone queue FIFO
+   reallocate when they double, and the monotone queue compacts its FIFO in one pass
+ - the byte stream and block headers of a history bucket (HistoryBucket::bytes and blocks) reallocate when they double
+ - the max-trees over history blocks and over bucket stays (growExitTree, IntervalIndex::growTree) are rebuilt in full
+   when their number of leaves doubles
+Each is amortized O(1) per entry but its cost lands on one command, proportional to the size of what grows.
+
+SUBMISSION FROM SEVERAL THREADS
+Jobs can also be handed to the scheduler from other threads instead of as text on stdin. Each producer thread pushes
+SubmittedJobs, in non-decreasing timestamp order, into a SubmissionRing of its own: a lock-free single producer /
+single consumer ring of batches of 256 jobs, so the producer and the consumer touch the shared indices once per batch.
+JobSubmission merges the rings by timestamp for the one thread that owns the Scheduler (addJob/assignJobs), so the
+scheduler still sees timestamps in order. A job is released only when no open producer can still send an earlier one:
+each has a job waiting or has promised with advance(T) that its next job is at T or later. A producer with nothing to
+send for a while calls advance() as a heartbeat instead of holding back the others. A batch that is not full is
+published on the producer's next push once the merge has found its ring empty, rather than waiting for 256 jobs.
+'--submit-bench=<P>' runs a synthetic trace through 1, 2, 4 .. P producers and prints jobs per second on stderr
+(older toolchains need -pthread to build).
+
+PROFILING
+'--profile=<prefix>' replays the trace with timers around each part of the scheduler: parsing, aging, heap insertion,
+the duration heaps (insert, flush and deferred flushes), MaxMins upkeep, the CPU tree (with its history), taking jobs
+out of the queues, history scans, printing assigned jobs, the waiting index (insert, erase, lookups and its growth),
+job storage (the job and queue position lists, interned origins and instruction text) and history upkeep (recording in
+qJobList and the bucket stays when a job leaves or changes its bucket). A part timed inside another, such as history
+upkeep during aging, is only counted in the inner one. Timers read the time stamp
+counter (RDTSC, a steady clock elsewhere) and cost a single test when profiling is off. Two files are written:
+ - <prefix>.csv: a 'total' row per kind of command with its cycles in each part, then the '--profile-top=<N>' (20)
+   slowest commands with their line number, text and what drove their cost: K, the timestamp window and number of
+   buckets and blocks a query looked through, and the jobs it assigned or printed
+ - <prefix>.folded: "command;part cycles" lines for flame graph tools; time in no part is left on the command itself
+In offline mode the sweep that answers the queries shows up as an 'offline_answer' command.
+
+SOME THINGS WE MISSED
+The process of finding free CPU's can be optimzed further. Once we reach time T, all CPU's with freeAfter <= T are equivalent for us and so the tree can be pruned by merging all these into a single node, reducing the tree size.
+This however will not leave the tree balanced and a custom balancing routine needs to be thought for it.
+
+Also to maintain our duration heaps we are flushing it into qJobList whenever we see a timestamp greater than a previously seen timestamp. While doing this, to avoid scanning through 100 buckets every time, we have maintained a totalSize variable so that when all the bucket heaps are empty we don't unnecessarily scan through them.
+*/
+
+
+
+// Class to store job information
+template<typename IdT,typename TimeT,typename DurT>
+class Job
+{
+    public:
+    ll processID;
+    TimeT timestamp;
+    TimeT qExit;
+    TimeT bucketExit; // Time when job left its original importance bucket
+    DurT duration;
+    const char *instruction; // kept in the scheduler's StringArena
+    IdT historyPos; // position in its qJobList bucket, max value until it is flushed there
+    unsigned int origin; // index of its originSystem in the scheduler's NameTable
+    unsigned short importance;
+    Job(){}
+    Job(ll processID,TimeT timestamp,unsigned int origin,const char *instruction,unsigned short importance,DurT duration,TimeT qExit)
+    {
+        this->processID = processID;
+        this->timestamp = timestamp;
+        this->origin = origin;
+        this->instruction = instruction;
+        this->importance = importance;
+        this->duration = duration;
+        this->qExit = qExit;
+        this->bucketExit = qExit;
+        this->historyPos = numeric_limits<IdT>::max();
+    }
+    // Prints the job with the importance it had at some point in history
+    void printDescription(ll epoch,unsigned short importance,const string &originSystem)
+    {
+        cout<<"job "<<(timestamp + epoch)<<" "<<processID<<" "<<originSystem<<" "<<instruction<<" "<<importance<<" "<<duration<<endl;
+    }
+    
+    
+};
+
+// Distinct origin systems of the trace. Each is kept once, as the key of the hash map, and jobs refer to it by the
+// index it was given.
+class NameTable
+{
+    public:
+    unordered_map<string,unsigned int> index;
+    vector<const string*> names; // keys of index, which do not move when it rehashes
+    
+    unsigned int intern(const string &name)
+    {
+        unordered_map<string,unsigned int>::iterator it = index.find(name);
+        if(it != index.end())
+            return it->second;
+        it = index.insert(make_pair(name,(unsigned int)names.size())).first;
+        names.push_back(&it->first);
+        return it->second;
+    }
+    
+    // Index of name, size() if it was never interned
+    unsigned int find(const string &name) const
+    {
+        unordered_map<string,unsigned int>::const_iterator it = index.find(name);
+        return it == index.end() ? names.size() : it->second;
+    }
+    
+    unsigned int size() const
+    {
+        return names.size();
+    }
+    
+    const string &operator[](unsigned int i) const
+    {
+        return *names[i];
+    }
+};
+
+// Append-only store for strings that are only printed back (instructions), packed NUL-terminated into 1MB blocks.
+// Unlike a NameTable it costs nothing per string beyond its characters, which suits strings that rarely repeat.
+class StringArena
+{
+    public:
+    static const ll BLOCK_SIZE = 1ULL << 20;
+    vector<char*> blocks;
+    ll used; // bytes taken in the last block
+    
+    StringArena()
+    {
+        used = BLOCK_SIZE;
+    }
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+    ~StringArena()
+    {
+        for(size_t i=0; i<blocks.size(); i++)
+            delete[] blocks[i];
+    }
+    
+    const char *add(const string &value)
+    {
+        ll bytes = value.size() + 1;
+        if(used + bytes > BLOCK_SIZE)
+        {
+            blocks.push_back(new char[max(BLOCK_SIZE,bytes)]);
+            used = 0;
+        }
+        char *copy = blocks.back() + used;
+        memcpy(copy,value.c_str(),bytes);
+        used += bytes;
+        return copy;
+    }
+};
+
+const ll StringArena::BLOCK_SIZE;
+
+// Number of times 2 divides n
+constexpr int trailingZeros(ll n)
+{
+    return (n & 1) ? 0 : 1 + trailingZeros(n >> 1);
+}
+
+// Stable storage for jobs: fixed size chunks that are never moved once allocated, so adding a job does not
+// copy the jobs before it and references to a job stay valid. A job is found from its position with a shift
+// and a mask. Chunks are backed by 2MB huge pages when the system has them, and hold the smallest power of two
+// of elements that fills a whole number of them, so no page is left part empty whatever the size of T.
+template<class T>
+class ChunkedList
+{
+    public:
+    static const int HUGE_PAGE_SHIFT = 21;
+    static const ll HUGE_PAGE_SIZE = 1ULL << HUGE_PAGE_SHIFT;
+    static const int CHUNK_SHIFT = HUGE_PAGE_SHIFT - trailingZeros(sizeof(T));
+    static const ll CHUNK_SIZE = 1ULL << CHUNK_SHIFT;
+    
+    vector<T*> chunks;
+    ll count;
+    
+    ChunkedList()
+    {
+        count = 0;
+    }
+    
+    // Owns its mappings, so it cannot be copied
+    ChunkedList(const ChunkedList &) = delete;
+    ChunkedList &operator=(const ChunkedList &) = delete;
+    
+    ~ChunkedList()
+    {
+        for(ll i=0; i<count; i++)
+            (*this)[i].~T();
+        for(ll i=0; i<chunks.size(); i++)
+            freeChunk(chunks[i]);
+    }
+    
+    ll size() const
+    {
+        return count;
+    }
+    
+    T &operator[](ll pos)
+    {
+        return chunks[pos >> CHUNK_SHIFT][pos & (CHUNK_SIZE - 1)];
+    }
+    
+    const T &operator[](ll pos) const
+    {
+        return chunks[pos >> CHUNK_SHIFT][pos & (CHUNK_SIZE - 1)];
+    }
+    
+    void push_back(const T &value)
+    {
+        if(count == chunks.size()*CHUNK_SIZE)
+            chunks.push_back(allocateChunk());
+        new(&(*this)[count]) T(value);
+        count++;
+    }
+    
+    // Allocates chunks up front for n elements. Their pages are faulted in here too, so that writing
+    // the elements later does not fault.
+    void reserve(ll n)
+    {
+        while(chunks.size()*CHUNK_SIZE < n)
+            chunks.push_back(allocateChunk(true));
+    }
+    
+    static ll chunkBytes()
+    {
+        return CHUNK_SIZE*sizeof(T);
+    }
+    
+    static T *allocateChunk(bool populate = false)
+    {
+#ifdef __linux__
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+        if(populate)
+            flags |= MAP_POPULATE;
+        void *memory = mmap(NULL,chunkBytes(),PROT_READ | PROT_WRITE,flags,-1,0);
+        if(memory != MAP_FAILED)
+            return (T*)memory;
+        
+        // No huge pages reserved, map a huge page aligned range and ask for transparent huge pages
+        char *mapped = (char*)mmap(NULL,chunkBytes() + HUGE_PAGE_SIZE,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        if(mapped == (char*)MAP_FAILED)
+        {
+            fprintf(stderr,"out of memory for %llu more entries\n",CHUNK_SIZE);
+            exit(1);
+        }
+        ll head = (HUGE_PAGE_SIZE - (ll)mapped % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+        if(head > 0)
+            munmap(mapped,head);
+        munmap(mapped + head + chunkBytes(),HUGE_PAGE_SIZE - head);
+#ifdef MADV_HUGEPAGE
+        madvise(mapped + head,chunkBytes(),MADV_HUGEPAGE);
+#endif
+        // MAP_POPULATE would fault the range in before the advice, with small pages, so touch it instead
+        if(populate)
+        {
+            ll pageSize = sysconf(_SC_PAGESIZE);
+            for(ll offset = 0; offset < chunkBytes(); offset += pageSize)
+                ((volatile char*)mapped)[head + offset] = 0;
+        }
+        return (T*)(mapped + head);
+#else
+        return (T*)operator new(chunkBytes());
+#endif
+    }
+    
+    static void freeChunk(T *chunk)
+    {
+#ifdef __linux__
+        munmap(chunk,chunkBytes());
+#else
+        operator delete(chunk);
+#endif
+    }
+};
+
+template<class T>
+const int ChunkedList<T>::HUGE_PAGE_SHIFT;
+template<class T>
+const ll ChunkedList<T>::HUGE_PAGE_SIZE;
+template<class T>
+const int ChunkedList<T>::CHUNK_SHIFT;
+template<class T>
+const ll ChunkedList<T>::CHUNK_SIZE;
+
+// Stores Max/Min Timestamp of a job residing in queue at
+// a particular timestamp
+template<typename TimeT>
+struct MaxMinNode
+{
+    TimeT Max,Min;
+    TimeT timestamp;
+    MaxMinNode(){}
+    MaxMinNode(TimeT Min,TimeT Max,TimeT timestamp)
+    {
+        this->Max = Max;
+        this->Min = Min;
+        this->timestamp = timestamp;
+    }
+    void updateValues(TimeT value)
+    {
+        Max = max(Max,value);
+        Min = min(Min,value);
+    }
+};
+
+// BST Node to store time after which CPU is free
+template<typename TimeT,typename CountT>
+class CPUNode
+{
+    public:
+    typedef TimeT ValueType;
+    typedef CountT CountType;
+    TimeT freeAfter;
+    CountT subtreeSize;
+    CountT freq;
+    int height;
+    CPUNode *left;
+    CPUNode *right;
+    CPUNode() {}
+    CPUNode(TimeT freeAfter,CountT freq)
+    {
+        this->freeAfter = freeAfter;
+        this->left = this->right = NULL;
+        this->freq = freq;
+        this->height = 1;
+    }
+};
+
+
+ll getLeft(ll pos)
+{
+    return (2*pos) + 1;
+}
+ll getRight(ll pos)
+{
+    return (2*pos) + 2;
+}
+ll getParent(ll pos)
+{
+    return ((pos-1)/2);
+}
+
+bool containsAlphabet(string s)
+{
+    for(ll i=0,l=s.length(); i<l; i++)
+        if(isalpha(s[i]))
+            return true;
+    return false;
+}
+
+ll convertStringToLL(string s)
+{
+    ll l = s.length();
+    ll result = 0;
+    ll k;
+    for(ll i=0; i<l; ++i)
+    {
+        k = s[i] - '0';
+        result = (result * 10) + k;
+    }
+    return result;
+}
+
+
+template<class Node>
+typename Node::CountType getSubtreeSize(Node *cpuNode)
+{
+    if(cpuNode == NULL)
+        return 0;
+    return cpuNode->subtreeSize;
+}
+
+template<class Node>
+int getHeight(Node *cpuNode)
+{
+    if(cpuNode == NULL)
+        return 0;
+    return cpuNode->height;
+}
+
+template<class Node>
+int getBalance(Node *cpuNode)
+{
+    if(cpuNode == NULL)
+        return 0;
+    return getHeight(cpuNode->left) - getHeight(cpuNode->right);
+}
+
+template<class Node>
+Node *rightRotate(Node *y)
+{
+    Node *x = y->left;
+    Node *T2 = x->right;
+ 
+    // Perform rotation
+    x->right = y;
+    y->left = T2;
+ 
+    // Update heights
+    y->height = max(getHeight(y->left), getHeight(y->right))+1;
+    x->height = max(getHeight(x->left), getHeight(x->right))+1;
+ 
+    y->subtreeSize = getSubtreeSize(y->left) + y->freq + getSubtreeSize(y->right);
+    x->subtreeSize = getSubtreeSize(x->left) + x->freq + getSubtreeSize(x->right);
+    // Return new root
+    return x;
+}
+ 
+template<class Node>
+Node *leftRotate(Node *x)
+{
+    Node *y = x->right;
+    Node *T2 = y->left;
+ 
+    // Perform rotation
+    y->left = x;
+    x->right = T2;
+ 
+    //  Update heights
+    x->height = max(getHeight(x->left), getHeight(x->right))+1;
+    y->height = max(getHeight(y->left), getHeight(y->right))+1;
+ 
+    x->subtreeSize = getSubtreeSize(x->left) + x->freq + getSubtreeSize(x->right);
+    y->subtreeSize = getSubtreeSize(y->left) + y->freq + getSubtreeSize(y->right);
+    
+    // Return new root
+    return y;
+}
+
+template<class Node>
+typename Node::ValueType getMinimum(Node *startTimeRoot)
+{
+    Node *root = startTimeRoot;
+    while(root->left)
+        root = root->left;
+    return root->freeAfter;
+}
+template<class Node>
+typename Node::ValueType getMaximum(Node *startTimeRoot)
+{
+    Node *root = startTimeRoot;
+    while(root->right)
+        root = root->right;
+    return root->freeAfter;
+}
+
+template<class Node>
+Node* createBST(typename Node::CountType noOfCPU)
+{
+    Node* root = NULL;
+    if(noOfCPU <= 0)
+        return root;
+    root = new Node(0,noOfCPU);
+    root->subtreeSize = noOfCPU;
+    return root;
+}
+
+template<class Node>
+typename Node::CountType getValuesLessThanEqualTo(Node *root,typename Node::ValueType value)
+{
+    if(root == NULL)
+        return 0;
+    if(root->freeAfter <= value)
+            return getSubtreeSize(root->left) + root->freq + getValuesLessThanEqualTo(root->right,value);
+    return getValuesLessThanEqualTo(root->left,value);
+}
+
+template<class Node>
+Node* deleteCPUNode(Node *root,typename Node::ValueType value)
+{
+    if(root == NULL)
+        return root;
+    if(root->freeAfter > value) //recurse on left
+        root->left = deleteCPUNode(root->left,value);
+    else if(root->left != NULL) //recurse on left
+        root->left = deleteCPUNode(root->left,value);
+    else if(root->freq > 1) //no recursion base case
+    {
+        root->subtreeSize = root->subtreeSize - 1;
+        root->freq = root->freq - 1;
+        return root;
+    }
+    else //delete current node
+    {
+        if(root->right == NULL)
+            return NULL;
+        *root = *(root->right);
+    }
+        
+    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
+    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
+    
+    int balance = getBalance(root);
+    
+    if(abs(balance) <= 1)
+        return root;
+    
+    if (balance > 1 && getBalance(root->left) >= 0)
+        return rightRotate(root);
+ 
+    // Left Right Case
+    if (balance > 1 && getBalance(root->left) < 0)
+    {
+        root->left =  leftRotate(root->left);
+        return rightRotate(root);
+    }
+ 
+    // Right Right Case
+    if (balance < -1 && getBalance(root->right) <= 0)
+        return leftRotate(root);
+ 
+    // Right Left Case
+    if (balance < -1 && getBalance(root->right) > 0)
+    {
+        root->right = rightRotate(root->right);
+        return leftRotate(root);
+    }   
+    return root;
+}
+
+template<class Node>
+Node* deleteCustom(Node *root,typename Node::ValueType value)
+{
+    if(root == NULL)
+        return root;
+    if(root->freeAfter > value) //recurse on left
+        root->left = deleteCustom(root->left,value);
+    else if(root->freeAfter < value) //recurse on left
+        root->right = deleteCustom(root->right,value);
+    else if(root->freq > 1) //no recursion base case
+    {
+        root->subtreeSize = root->subtreeSize - 1;
+        root->freq = root->freq - 1;
+        return root;
+    }
+    else //delete current node
+    {
+        if( (root->left == NULL) || (root->right == NULL) )
+        {
+            Node *temp = root->left ? root->left : root->right;
+            // No child case
+            if(temp == NULL)
+            {
+                temp = root;
+                root = NULL;
+            }
+            else // One child case
+             *root = *temp;
+            delete temp;
+        }
+        else
+        {
+            typename Node::ValueType temp = getMinimum(root->right);
+            root->freeAfter = temp;
+            root->right = deleteCustom(root->right, temp);
+        }
+    }
+        
+    if(root == NULL)
+        return NULL;
+    
+    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
+    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
+    
+    int balance = getBalance(root);
+    
+    if(abs(balance) <= 1)
+        return root;
+    
+    if (balance > 1 && getBalance(root->left) >= 0)
+        return rightRotate(root);
+ 
+    // Left Right Case
+    if (balance > 1 && getBalance(root->left) < 0)
+    {
+        root->left =  leftRotate(root->left);
+        return rightRotate(root);
+    }
+ 
+    // Right Right Case
+    if (balance < -1 && getBalance(root->right) <= 0)
+        return leftRotate(root);
+ 
+    // Right Left Case
+    if (balance < -1 && getBalance(root->right) > 0)
+    {
+        root->right = rightRotate(root->right);
+        return leftRotate(root);
+    }   
+    return root;
+}
+
+
+template<class Node>
+Node* insertCPUNode(Node *root,typename Node::ValueType value)
+{
+    if(root == NULL)
+    {
+        root = new Node(value,1);
+        root->subtreeSize = 1;
+        return root;
+    }
+    if(root->freeAfter == value)
+    {
+        root->subtreeSize = root->subtreeSize + 1;
+        root->freq = root->freq + 1;
+        return root;
+    }
+    
+    if(root->freeAfter < value)
+        root->right = insertCPUNode(root->right,value);
+    else root->left = insertCPUNode(root->left,value);
+    
+    root->subtreeSize = getSubtreeSize(root->left) + root->freq + getSubtreeSize(root->right);
+    root->height = max(getHeight(root->left),getHeight(root->right)) + 1;
+    
+    int balance = getBalance(root);
+    if(abs(balance) <= 1)
+        return root;
+    // Left Left Case
+    if (balance > 1 && value < root->left->freeAfter)
+        return rightRotate(root);
+ 
+    // Right Right Case
+    if (balance < -1 && value > root->right->freeAfter)
+        return leftRotate(root);
+ 
+    // Left Right Case
+    if (balance > 1 && value > root->left->freeAfter)
+    {
+        root->left =  leftRotate(root->left);
+        return rightRotate(root);
+    }
+ 
+    // Right Left Case
+    if (balance < -1 && value < root->right->freeAfter)
+    {
+        root->right = rightRotate(root->right);
+        return leftRotate(root);
+    }
+    
+    return root;
+}
+
+// Past versions of the CPU free-time tree, for 'cpuquery'. Versions are persistent AVL trees of the same shape as the
+// CPU tree: starting a job copies only the O(logM) nodes on the paths it changes and shares the rest with the previous
+// version. Nodes are reference counted, so dropping the oldest versions to stay under the memory cap frees exactly
+// the nodes no remaining version uses.
+template<typename TimeT,typename CountT>
+class CPUHistory
+{
+    public:
+    struct VersionNode
+    {
+        typedef TimeT ValueType;
+        typedef CountT CountType;
+        TimeT freeAfter;
+        CountT subtreeSize;
+        CountT freq;
+        int height;
+        unsigned int refs;
+        VersionNode *left;
+        VersionNode *right;
+    };
+    
+    // Bytes malloc takes for a node: a size word in front, rounded up to 16 bytes
+    static const ll NODE_BYTES = (sizeof(VersionNode) + sizeof(size_t) + 15) & ~(ll)15;
+    
+    deque< pair<TimeT,VersionNode*> > versions; // root after the last assign at each timestamp
+    VersionNode *current;
+    ll liveNodes;
+    ll maxBytes;
+    bool dropped; // versions were dropped to stay under the cap
+    
+    CPUHistory()
+    {
+        current = NULL;
+        liveNodes = 0;
+        maxBytes = 0;
+        dropped = false;
+    }
+    
+    // Memory taken by the nodes and the list of versions
+    ll usedBytes()
+    {
+        return liveNodes*NODE_BYTES + (ll)versions.size()*sizeof(versions[0]);
+    }
+    
+    VersionNode *makeNode(TimeT freeAfter,CountT freq,VersionNode *left,VersionNode *right)
+    {
+        VersionNode *node = new VersionNode();
+        node->freeAfter = freeAfter;
+        node->freq = freq;
+        node->left = left;
+        node->right = right;
+        node->refs = 0;
+        node->height = max(getHeight(left),getHeight(right)) + 1;
+        node->subtreeSize = getSubtreeSize(left) + freq + getSubtreeSize(right);
+        if(left)
+            left->refs++;
+        if(right)
+            right->refs++;
+        liveNodes++;
+        return node;
+    }
+    
+    void unref(VersionNode *node)
+    {
+        if(node != NULL && --node->refs == 0)
+            destroy(node);
+    }
+    
+    void destroy(VersionNode *node)
+    {
+        unref(node->left);
+        unref(node->right);
+        delete node;
+        liveNodes--;
+    }
+    
+    // Frees a node built on the way that did not end up in the new version
+    void discard(VersionNode *node)
+    {
+        if(node != NULL && node->refs == 0)
+            destroy(node);
+    }
+    
+    // New node for (freeAfter,freq) over left and right, rotated if they differ in height by more than one
+    VersionNode *balance(TimeT freeAfter,CountT freq,VersionNode *left,VersionNode *right)
+    {
+        if(getHeight(left) > getHeight(right) + 1)
+        {
+            if(getHeight(left->left) >= getHeight(left->right))
+                return makeNode(left->freeAfter,left->freq,left->left,makeNode(freeAfter,freq,left->right,right));
+            VersionNode *middle = left->right;
+            return makeNode(middle->freeAfter,middle->freq,makeNode(left->freeAfter,left->freq,left->left,middle->left),makeNode(freeAfter,freq,middle->right,right));
+        }
+        if(getHeight(right) > getHeight(left) + 1)
+        {
+            if(getHeight(right->right) >= getHeight(right->left))
+                return makeNode(right->freeAfter,right->freq,makeNode(freeAfter,freq,left,right->left),right->right);
+            VersionNode *middle = right->left;
+            return makeNode(middle->freeAfter,middle->freq,makeNode(freeAfter,freq,left,middle->left),makeNode(right->freeAfter,right->freq,middle->right,right->right));
+        }
+        return makeNode(freeAfter,freq,left,right);
+    }
+    
+    VersionNode *insert(VersionNode *root,TimeT value)
+    {
+        if(root == NULL)
+            return makeNode(value,1,NULL,NULL);
+        if(root->freeAfter == value)
+            return makeNode(value,root->freq + 1,root->left,root->right);
+        VersionNode *result,*child;
+        if(value < root->freeAfter)
+        {
+            child = insert(root->left,value);
+            result = balance(root->freeAfter,root->freq,child,root->right);
+        }
+        else
+        {
+            child = insert(root->right,value);
+            result = balance(root->freeAfter,root->freq,root->left,child);
+        }
+        discard(child);
+        return result;
+    }
+    
+    // Removes one CPU with the smallest freeAfter, as deleteCPUNode does
+    VersionNode *deleteMinimum(VersionNode *root)
+    {
+        if(root->left == NULL)
+        {
+            if(root->freq > 1)
+                return makeNode(root->freeAfter,root->freq - 1,NULL,root->right);
+            return root->right;
+        }
+        VersionNode *child = deleteMinimum(root->left);
+        VersionNode *result = balance(root->freeAfter,root->freq,child,root->right);
+        discard(child);
+        return result;
+    }
+    
+    void setCurrent(VersionNode *root)
+    {
+        if(root)
+            root->refs++;
+        unref(current);
+        current = root;
+    }
+    
+    void reset(CountT noOfCPU,ll memoryCap)
+    {
+        maxBytes = memoryCap;
+        setCurrent(noOfCPU > 0 ? makeNode(0,noOfCPU,NULL,NULL) : NULL);
+        commit(0);
+    }
+    
+    // A CPU that was free by now runs a job until freeAfter
+    void startJob(TimeT freeAfter)
+    {
+        VersionNode *removed = deleteMinimum(current);
+        VersionNode *next = insert(removed,freeAfter);
+        if(removed)
+            removed->refs++;
+        setCurrent(next);
+        unref(removed);
+    }
+    
+    // Keeps the current tree as the version at timestamp, dropping the oldest versions while over the cap
+    void commit(TimeT timestamp)
+    {
+        if(current)
+            current->refs++;
+        if(versions.size() && versions.back().first == timestamp)
+        {
+            unref(versions.back().second);
+            versions.back().second = current;
+        }
+        else versions.push_back(make_pair(timestamp,current));
+        while(usedBytes() > maxBytes && versions.size() > 1)
+        {
+            unref(versions.front().second);
+            versions.pop_front();
+            dropped = true;
+        }
+    }
+    
+    // Version in effect at timestamp, false if it was dropped
+    bool findVersion(TimeT timestamp,VersionNode *&root)
+    {
+        ll left = 0,right = versions.size();
+        while(left < right)
+        {
+            ll mid = (left + right)/2;
+            if(versions[mid].first <= timestamp)
+                left = mid + 1;
+            else right = mid;
+        }
+        if(left == 0)
+            return false;
+        root = versions[left - 1].second;
+        return true;
+    }
+    
+    // CPUs busy at timestamp and the earliest time after it that one of them becomes free (0 if none is busy)
+    void busyAt(VersionNode *root,TimeT timestamp,CountT &busy,TimeT &nextFree)
+    {
+        busy = 0;
+        nextFree = 0;
+        for(VersionNode *node = root; node != NULL; )
+        {
+            if(node->freeAfter <= timestamp)
+                node = node->right;
+            else
+            {
+                busy += node->freq + getSubtreeSize(node->right);
+                nextFree = node->freeAfter;
+                node = node->left;
+            }
+        }
+    }
+};
+
+
+void appendVarint(vector<unsigned char> &bytes,ll value)
+{
+    while(value >= 128)
+    {
+        bytes.push_back((value & 127) | 128);
+        value >>= 7;
+    }
+    bytes.push_back(value);
+}
+
+ll readVarint(const unsigned char *&p)
+{
+    ll value = 0;
+    int shift = 0;
+    while(*p & 128)
+    {
+        value |= (ll)(*p++ & 127) << shift;
+        shift += 7;
+    }
+    value |= (ll)(*p++) << shift;
+    return value;
+}
+
+// Header of a sealed block of history. The first entry is stored here and the rest
+// as varint deltas from their predecessor in the bucket's byte stream.
+template<typename IdT,typename TimeT>
+struct HistoryBlock
+{
+    TimeT minTimestamp,maxTimestamp;
+    TimeT maxExited; // latest exit of the jobs that left the queue
+    IdT firstID;
+    IdT waiting; // jobs in the block still in the queue
+    ll offset; // position of the second entry in the byte stream
+};
+
+// History of one importance bucket in increasing order of timestamp.
+// Entries are appended to an uncompressed tail which is sealed into a delta-encoded
+// block once it holds BLOCK_SIZE entries. Block headers keep the timestamp range of the
+// block and when its last job left so that searches and scans can skip whole blocks.
+template<typename IdT,typename TimeT,int BLOCK_SIZE>
+class HistoryBucket
+{
+    public:
+    static const TimeT NOT_EXITED = numeric_limits<TimeT>::max();
+    
+    vector< HistoryBlock<IdT,TimeT> > blocks;
+    vector<unsigned char> bytes;
+    vector<IdT> tailIDs;
+    vector<TimeT> tailTimestamps;
+    vector<TimeT> tailQExits;
+    
+    // Max-tree over the sealed blocks of the time their last job left (NOT_EXITED while one is waiting).
+    // Finds the next block with a job still in the bucket at T in O(logB), however many blocks before it
+    // are fully exited.
+    vector<TimeT> exitTree;
+    ll treeLeaves;
+    
+    HistoryBucket()
+    {
+        treeLeaves = 0;
+    }
+    
+    ll size()
+    {
+        return (ll)blocks.size()*BLOCK_SIZE + tailIDs.size();
+    }
+    
+    TimeT firstTimestamp()
+    {
+        return blocks.size() ? blocks[0].minTimestamp : tailTimestamps[0];
+    }
+    
+    TimeT lastTimestamp()
+    {
+        return tailTimestamps.size() ? tailTimestamps[tailTimestamps.size()-1] : blocks[blocks.size()-1].maxTimestamp;
+    }
+    
+    void push_back(IdT jobID,TimeT timestamp,TimeT qExit)
+    {
+        tailIDs.push_back(jobID);
+        tailTimestamps.push_back(timestamp);
+        tailQExits.push_back(qExit);
+        if(tailIDs.size() == BLOCK_SIZE)
+            seal();
+    }
+    
+    void seal()
+    {
+        HistoryBlock<IdT,TimeT> block;
+        block.minTimestamp = tailTimestamps[0];
+        block.maxTimestamp = tailTimestamps[BLOCK_SIZE-1];
+        block.firstID = tailIDs[0];
+        block.offset = bytes.size();
+        block.waiting = 0;
+        block.maxExited = 0;
+        for(int i=0; i<BLOCK_SIZE; i++)
+        {
+            if(i > 0)
+            {
+                // IDs within a bucket are not monotonic (same timestamp jobs are ordered by duration) so zigzag them
+                long long idDelta = (long long)tailIDs[i] - (long long)tailIDs[i-1];
+                appendVarint(bytes,tailTimestamps[i] - tailTimestamps[i-1]);
+                appendVarint(bytes,idDelta >= 0 ? (ll)idDelta << 1 : (((ll)(-idDelta)) << 1) - 1);
+            }
+            if(tailQExits[i] == NOT_EXITED)
+                block.waiting++;
+            else block.maxExited = max(block.maxExited,tailQExits[i]);
+        }
+        blocks.push_back(block);
+        if((ll)blocks.size() > treeLeaves)
+            growExitTree();
+        else setLatestExit(blocks.size() - 1);
+        tailIDs.clear();
+        tailTimestamps.clear();
+        tailQExits.clear();
+    }
+    
+    // Records that the job at position pos left the queue at qExit
+    void markExited(ll pos,TimeT qExit)
+    {
+        ll blockIndex = pos / BLOCK_SIZE;
+        if(blockIndex == (ll)blocks.size())
+        {
+            tailQExits[pos - blockIndex*BLOCK_SIZE] = qExit;
+            return;
+        }
+        HistoryBlock<IdT,TimeT> &block = blocks[blockIndex];
+        block.waiting--;
+        block.maxExited = max(block.maxExited,qExit);
+        if(block.waiting == 0)
+            setLatestExit(blockIndex);
+    }
+    
+    TimeT latestExit(ll blockIndex)
+    {
+        return blocks[blockIndex].waiting ? NOT_EXITED : blocks[blockIndex].maxExited;
+    }
+    
+    void setLatestExit(ll blockIndex)
+    {
+        ll node = treeLeaves + blockIndex;
+        exitTree[node] = latestExit(blockIndex);
+        for(node /= 2; node >= 1; node /= 2)
+            exitTree[node] = max(exitTree[2*node],exitTree[2*node+1]);
+    }
+    
+    // Doubles the number of leaves and rebuilds, amortized O(1) per sealed block
+    void growExitTree()
+    {
+        treeLeaves = max(1LL,2*(long long)treeLeaves);
+        exitTree.assign(2*treeLeaves,0);
+        for(ll i=0; i<(ll)blocks.size(); i++)
+            exitTree[treeLeaves + i] = latestExit(i);
+        for(ll node=treeLeaves-1; node>=1; node--)
+            exitTree[node] = max(exitTree[2*node],exitTree[2*node+1]);
+    }
+    
+    // First block >= blockIndex in the subtree of node (covering [low,high)) with a job in the bucket after timestamp, -1 if none
+    long long findLiveBlock(ll node,ll low,ll high,ll blockIndex,TimeT timestamp)
+    {
+        if(high <= blockIndex || exitTree[node] <= timestamp)
+            return -1;
+        if(high - low == 1)
+            return low;
+        ll mid = (low + high)/2;
+        long long found = findLiveBlock(2*node,low,mid,blockIndex,timestamp);
+        if(found >= 0)
+            return found;
+        return findLiveBlock(2*node+1,mid,high,blockIndex,timestamp);
+    }
+    
+    // Start of the first block at or after pos which had a job in the bucket at timestamp.
+    // The unsealed tail is always scanned.
+    ll nextLiveBlock(ll pos,TimeT timestamp)
+    {
+        ll blockIndex = pos / BLOCK_SIZE;
+        if(blockIndex >= (ll)blocks.size())
+            return pos;
+        long long found = findLiveBlock(1,0,treeLeaves,blockIndex,timestamp);
+        return (found >= 0 ? found : (ll)blocks.size())*BLOCK_SIZE;
+    }
+    
+    ll blockStart(ll pos)
+    {
+        return pos - (pos % BLOCK_SIZE);
+    }
+    
+    // Decodes the block containing pos, returns the number of entries in it
+    ll decodeBlock(ll pos,IdT *jobIDs,TimeT *timestamps)
+    {
+        ll blockIndex = pos / BLOCK_SIZE;
+        if(blockIndex == (ll)blocks.size())
+        {
+            copy(tailIDs.begin(),tailIDs.end(),jobIDs);
+            copy(tailTimestamps.begin(),tailTimestamps.end(),timestamps);
+            return tailIDs.size();
+        }
+        const HistoryBlock<IdT,TimeT> &block = blocks[blockIndex];
+        const unsigned char *p = &bytes[block.offset];
+        jobIDs[0] = block.firstID;
+        timestamps[0] = block.minTimestamp;
+        for(int i=1; i<BLOCK_SIZE; i++)
+        {
+            timestamps[i] = timestamps[i-1] + readVarint(p);
+            ll zigzag = readVarint(p);
+            jobIDs[i] = (zigzag & 1) ? jobIDs[i-1] - (IdT)((zigzag + 1) >> 1) : jobIDs[i-1] + (IdT)(zigzag >> 1);
+        }
+        return BLOCK_SIZE;
+    }
+    
+    // First position whose timestamp is >= value (or > value if strict), size() if there is none
+    ll getBoundary(TimeT value,bool strict)
+    {
+        ll left = 0,right = blocks.size();
+        while(left < right)
+        {
+            ll mid = (left + right)/2;
+            TimeT blockMax = blocks[mid].maxTimestamp;
+            if(blockMax > value || (!strict && blockMax == value))
+                right = mid;
+            else left = mid + 1;
+        }
+        
+        TimeT *begin,*end;
+        TimeT timestamps[BLOCK_SIZE];
+        IdT jobIDs[BLOCK_SIZE];
+        if(left < (ll)blocks.size())
+        {
+            decodeBlock(left*BLOCK_SIZE,jobIDs,timestamps);
+            begin = timestamps;
+            end = timestamps + BLOCK_SIZE;
+        }
+        else
+        {
+            if(tailTimestamps.size() == 0)
+                return size();
+            begin = &tailTimestamps[0];
+            end = begin + tailTimestamps.size();
+        }
+        TimeT *found = strict ? upper_bound(begin,end,value) : lower_bound(begin,end,value);
+        return left*BLOCK_SIZE + (found - begin);
+    }
+};
+
+template<typename IdT,typename TimeT,int BLOCK_SIZE>
+const TimeT HistoryBucket<IdT,TimeT,BLOCK_SIZE>::NOT_EXITED;
+
+// Intervals [from,until) added in increasing order of 'from', each standing for an item of the caller.
+// 'until' can be set later. A max-tree over 'until' finds the intervals open at a time T in O((r + 1)logn)
+// for r of them, however many had already ended by T.
+template<typename TimeT>
+class IntervalIndex
+{
+    public:
+    vector<TimeT> froms;
+    vector<ll> items;
+    vector<TimeT> untilTree;
+    ll treeLeaves;
+    
+    IntervalIndex()
+    {
+        treeLeaves = 0;
+    }
+    
+    // Returns the position of the interval, for setUntil
+    ll add(TimeT from,TimeT until,ll item)
+    {
+        froms.push_back(from);
+        items.push_back(item);
+        if((ll)froms.size() > treeLeaves)
+            growTree();
+        setUntil(froms.size() - 1,until);
+        return froms.size() - 1;
+    }
+    
+    void setUntil(ll pos,TimeT until)
+    {
+        ll node = treeLeaves + pos;
+        untilTree[node] = until;
+        for(node /= 2; node >= 1; node /= 2)
+            untilTree[node] = max(untilTree[2*node],untilTree[2*node+1]);
+    }
+    
+    // Doubles the number of leaves and rebuilds, amortized O(1) per interval
+    void growTree()
+    {
+        ll oldLeaves = treeLeaves;
+        treeLeaves = max(1LL,2*(long long)treeLeaves);
+        vector<TimeT> tree(2*treeLeaves,0);
+        for(ll i=0; i<oldLeaves; i++)
+            tree[treeLeaves + i] = untilTree[oldLeaves + i];
+        for(ll node=treeLeaves-1; node>=1; node--)
+            tree[node] = max(tree[2*node],tree[2*node+1]);
+        untilTree.swap(tree);
+    }
+    
+    // Appends the items of the intervals with from <= timestamp < until
+    void findOpen(TimeT timestamp,vector<ll> &found)
+    {
+        ll end = upper_bound(froms.begin(),froms.end(),timestamp) - froms.begin();
+        if(end > 0)
+            findOpen(1,0,treeLeaves,end,timestamp,found);
+    }
+    
+    // Intervals before end in the subtree of node (covering [low,high)) still open after timestamp
+    void findOpen(ll node,ll low,ll high,ll end,TimeT timestamp,vector<ll> &found)
+    {
+        if(low >= end || untilTree[node] <= timestamp)
+            return;
+        if(high - low == 1)
+        {
+            found.push_back(items[low]);
+            return;
+        }
+        ll mid = (low + high)/2;
+        findOpen(2*node,low,mid,end,timestamp,found);
+        findOpen(2*node+1,mid,high,end,timestamp,found);
+    }
+};
+
+
+/*
+JOB QUEUE BACKENDS
+Each importance bucket of waiting jobs is kept in one of the queues below, selected at startup with '--heap='.
+All of them hold job IDs, order them with a Compare object (Compare(a,b) is true when job a must be assigned
+before job b) and provide:
+ - insert(jobID)
+ - extract()          : removes and returns the highest priority job
+ - extractK(K,out)    : appends the min(K,size()) highest priority jobs to out, in priority order
+ - remove(jobID)      : removes a job from anywhere in the queue
+ - size()
+A job can be inserted again after remove(), possibly with a timestamp older than jobs already in the queue
+(reprioritize and aging move jobs between buckets).
+Compare::position(jobID) is a per-job slot the queue uses to find a job again for remove().
+*/
+
+// d-ary max-heap, D = 2 is the standard binary heap
+template<typename IdT,class Compare,int D>
+class DaryJobHeap
+{
+    public:
+    Compare higher;
+    vector<IdT> jobHeap;
+    IdT jobHeapSize;
+    
+    DaryJobHeap()
+    {
+        jobHeapSize = 0;
+    }
+    
+    void setCompare(const Compare &higher)
+    {
+        this->higher = higher;
+    }
+    
+    IdT size()
+    {
+        return jobHeapSize;
+    }
+    
+    void place(IdT jobID,IdT pos)
+    {
+        jobHeap[pos] = jobID;
+        higher.position(jobID) = pos;
+    }
+    
+    void siftUp(IdT pos)
+    {
+        IdT jobID = jobHeap[pos];
+        while(pos > 0)
+        {
+            IdT parent = (pos - 1)/D;
+            if(!higher(jobID,jobHeap[parent]))
+                break;
+            place(jobHeap[parent],pos);
+            pos = parent;
+        }
+        place(jobID,pos);
+    }
+    
+    void siftDown(IdT pos)
+    {
+        IdT jobID = jobHeap[pos];
+        while(1)
+        {
+            ll firstChild = (ll)D*pos + 1;
+            if(firstChild >= jobHeapSize)
+                break;
+            ll maxPos = firstChild;
+            for(ll child=firstChild+1,last=min(firstChild+D,(ll)jobHeapSize); child<last; ++child)
+                if(higher(jobHeap[child],jobHeap[maxPos]))
+                    maxPos = child;
+            if(!higher(jobHeap[maxPos],jobID))
+                break;
+            place(jobHeap[maxPos],pos);
+            pos = maxPos;
+        }
+        place(jobID,pos);
+    }
+    
+    void insert(IdT jobID)
+    {
+        if(jobHeapSize + 1 > jobHeap.size())
+            jobHeap.push_back(jobID);
+        else jobHeap[jobHeapSize] = jobID;
+        siftUp(jobHeapSize++);
+    }
+    
+    IdT extract()
+    {
+        IdT jobID = jobHeap[0];
+        jobHeapSize--;
+        if(jobHeapSize > 0)
+        {
+            jobHeap[0] = jobHeap[jobHeapSize];
+            siftDown(0);
+        }
+        return jobID;
+    }
+    
+    void extractK(ll K,vector<IdT> &out)
+    {
+        // Draining the whole heap is a single sort
+        if(K >= jobHeapSize)
+        {
+            sort(jobHeap.begin(),jobHeap.begin() + jobHeapSize,higher);
+            out.insert(out.end(),jobHeap.begin(),jobHeap.begin() + jobHeapSize);
+            jobHeapSize = 0;
+            return;
+        }
+        while(K--)
+            out.push_back(extract());
+    }
+    
+    void remove(IdT jobID)
+    {
+        IdT pos = higher.position(jobID);
+        jobHeapSize--;
+        if(pos == jobHeapSize)
+            return;
+        // Move the last job into the hole and restore the heap in whichever direction it is violated
+        jobHeap[pos] = jobHeap[jobHeapSize];
+        if(pos > 0 && higher(jobHeap[pos],jobHeap[(pos - 1)/D]))
+            siftUp(pos);
+        else siftDown(pos);
+    }
+};
+
+template<typename IdT,class Compare>
+class BinaryJobHeap : public DaryJobHeap<IdT,Compare,2> {};
+
+template<typename IdT,class Compare>
+class FourAryJobHeap : public DaryJobHeap<IdT,Compare,4> {};
+
+// Pairing heap over a pool of nodes, freed nodes are reused
+template<typename IdT,class Compare>
+class PairingJobHeap
+{
+    public:
+    static const IdT NIL = numeric_limits<IdT>::max();
+    struct PairingNode
+    {
+        IdT jobID;
+        IdT child;
+        IdT sibling;
+        IdT prev; // parent for a leftmost child, left sibling otherwise
+    };
+    
+    Compare higher;
+    vector<PairingNode> nodes;
+    vector<IdT> freeNodes;
+    vector<IdT> pairs; // scratch space for mergePairs
+    IdT root;
+    IdT count;
+    
+    PairingJobHeap()
+    {
+        root = NIL;
+        count = 0;
+    }
+    
+    void setCompare(const Compare &higher)
+    {
+        this->higher = higher;
+    }
+    
+    IdT size()
+    {
+        return count;
+    }
+    
+    IdT meld(IdT a,IdT b)
+    {
+        if(a == NIL)
+            return b;
+        if(b == NIL)
+            return a;
+        if(higher(nodes[b].jobID,nodes[a].jobID))
+            swap(a,b);
+        IdT child = nodes[a].child;
+        nodes[b].sibling = child;
+        if(child != NIL)
+            nodes[child].prev = b;
+        nodes[b].prev = a;
+        nodes[a].child = b;
+        return a;
+    }
+    
+    // Two pass pairing: meld the list of siblings pairwise left to right, then meld the pairs right to left
+    IdT mergePairs(IdT child)
+    {
+        pairs.clear();
+        while(child != NIL)
+        {
+            IdT first = child;
+            IdT second = nodes[first].sibling;
+            child = (second == NIL) ? NIL : nodes[second].sibling;
+            nodes[first].sibling = nodes[first].prev = NIL;
+            if(second != NIL)
+                nodes[second].sibling = nodes[second].prev = NIL;
+            pairs.push_back(meld(first,second));
+        }
+        IdT merged = NIL;
+        for(ll i=pairs.size(); i>0; --i)
+            merged = meld(pairs[i-1],merged);
+        return merged;
+    }
+    
+    void insert(IdT jobID)
+    {
+        IdT node;
+        if(freeNodes.size())
+        {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else
+        {
+            node = nodes.size();
+            nodes.push_back(PairingNode());
+        }
+        nodes[node].jobID = jobID;
+        nodes[node].child = nodes[node].sibling = nodes[node].prev = NIL;
+        higher.position(jobID) = node;
+        root = meld(root,node);
+        count++;
+    }
+    
+    IdT extract()
+    {
+        IdT jobID = nodes[root].jobID;
+        freeNodes.push_back(root);
+        count--;
+        root = mergePairs(nodes[root].child);
+        return jobID;
+    }
+    
+    void extractK(ll K,vector<IdT> &out)
+    {
+        for(K=min(K,(ll)count); K>0; --K)
+            out.push_back(extract());
+    }
+    
+    void remove(IdT jobID)
+    {
+        IdT node = higher.position(jobID);
+        if(node == root)
+        {
+            extract();
+            return;
+        }
+        
+        // Cut the subtree out of its sibling list
+        IdT prev = nodes[node].prev;
+        IdT sibling = nodes[node].sibling;
+        if(nodes[prev].child == node)
+            nodes[prev].child = sibling;
+        else nodes[prev].sibling = sibling;
+        if(sibling != NIL)
+            nodes[sibling].prev = prev;
+        
+        freeNodes.push_back(node);
+        count--;
+        root = meld(root,mergePairs(nodes[node].child));
+    }
+};
+
+template<typename IdT,class Compare>
+const IdT PairingJobHeap<IdT,Compare>::NIL;
+
+// Uses the fact that jobs enter a bucket in non-decreasing order of timestamp: jobs with an older timestamp than
+// the latest one are already in final order in a FIFO, only jobs sharing the latest timestamp need a heap
+// (ordered by duration). Compare::arrival(jobID) gives the timestamp of a job.
+// A job removed from the FIFO leaves a hole, the FIFO is compacted once holes and consumed entries make up half of it.
+// The bounds are amortized: remove is O(1) but the remove that triggers a compaction takes O(n), paid for by the n/2
+// removes and extracts before it, and extract skips every hole in front of the next job, each hole once.
+// Jobs moved in from another bucket are usually older than the latest timestamp, they go to a separate heap.
+template<typename IdT,class Compare>
+class MonotoneJobQueue
+{
+    public:
+    static const IdT HOLE = numeric_limits<IdT>::max();
+    Compare higher;
+    vector<IdT> fifo;
+    IdT head;
+    IdT holes; // holes at or after head
+    BinaryJobHeap<IdT,Compare> latest;
+    BinaryJobHeap<IdT,Compare> reinserted;
+    ll latestArrival;
+    
+    MonotoneJobQueue()
+    {
+        head = 0;
+        holes = 0;
+        latestArrival = 0;
+    }
+    
+    void setCompare(const Compare &higher)
+    {
+        this->higher = higher;
+        latest.setCompare(higher);
+        reinserted.setCompare(higher);
+    }
+    
+    IdT size()
+    {
+        return (fifo.size() - head - holes) + latest.size() + reinserted.size();
+    }
+    
+    void compact()
+    {
+        IdT last = 0;
+        for(IdT i=head; i<fifo.size(); i++)
+        {
+            if(fifo[i] == HOLE)
+                continue;
+            fifo[last] = fifo[i];
+            higher.position(fifo[last]) = last;
+            last++;
+        }
+        fifo.resize(last);
+        head = 0;
+        holes = 0;
+    }
+    
+    void skipHoles()
+    {
+        while(head < fifo.size() && fifo[head] == HOLE)
+        {
+            head++;
+            holes--;
+        }
+        if(head == fifo.size())
+        {
+            fifo.clear();
+            head = 0;
+        }
+    }
+    
+    void insert(IdT jobID)
+    {
+        ll arrival = higher.arrival(jobID);
+        if(arrival < latestArrival && size() > 0)
+        {
+            reinserted.insert(jobID);
+            return;
+        }
+        if(latest.size() > 0 && arrival != latestArrival)
+        {
+            // Compact the FIFO before it grows past twice the waiting jobs
+            if(2*(head + holes) >= fifo.size() && head + holes > 0)
+                compact();
+            IdT start = fifo.size();
+            latest.extractK(latest.size(),fifo);
+            for(IdT i=start; i<fifo.size(); i++)
+                higher.position(fifo[i]) = i;
+        }
+        latestArrival = arrival;
+        latest.insert(jobID);
+    }
+    
+    IdT extract()
+    {
+        skipHoles();
+        if(reinserted.size() > 0)
+        {
+            // The FIFO front, if any, beats the latest heap
+            if(head == fifo.size() && latest.size() == 0)
+                return reinserted.extract();
+            IdT best = (head < fifo.size()) ? fifo[head] : latest.jobHeap[0];
+            if(higher(reinserted.jobHeap[0],best))
+                return reinserted.extract();
+        }
+        if(head < fifo.size())
+        {
+            IdT jobID = fifo[head++];
+            skipHoles();
+            return jobID;
+        }
+        return latest.extract();
+    }
+    
+    void extractK(ll K,vector<IdT> &out)
+    {
+        if(reinserted.size() > 0)
+        {
+            for(K=min(K,(ll)size()); K>0; --K)
+                out.push_back(extract());
+            return;
+        }
+        skipHoles();
+        while(K > 0 && head < fifo.size())
+        {
+            out.push_back(fifo[head++]);
+            K--;
+            skipHoles();
+        }
+        latest.extractK(K,out);
+    }
+    
+    void remove(IdT jobID)
+    {
+        if(latest.size() > 0 && higher.arrival(jobID) == latestArrival)
+        {
+            latest.remove(jobID);
+            return;
+        }
+        IdT pos = higher.position(jobID);
+        if(pos < head || pos >= fifo.size() || fifo[pos] != jobID)
+        {
+            reinserted.remove(jobID);
+            return;
+        }
+        fifo[pos] = HOLE;
+        holes++;
+        // O(n), at most once every n/2 removes and extracts
+        if(2*(head + holes) >= fifo.size())
+            compact();
+    }
+};
+
+template<typename IdT,class Compare>
+const IdT MonotoneJobQueue<IdT,Compare>::HOLE;
+
+
+// A 'job' command handed over by a producer thread (see SUBMISSION FROM SEVERAL THREADS)
+struct SubmittedJob
+{
+    ll timestamp;
+    ll processID;
+    ll importance;
+    ll duration;
+    string originSystem;
+    string instruction;
+};
+
+// Lock-free ring of batches from one producer thread to the consumer. The producer fills a batch of its own and
+// publishes it with a single release store of tail; the consumer gives a read batch back with a single release store
+// of head. The threads therefore share a cache line once per batch rather than once per entry. Batches are swapped in
+// and out of the slots so their storage is reused, and neither side allocates once the ring is warm.
+// A batch that is not full is published anyway on the next push while the consumer is waiting on the ring, and
+// advance() publishes it along with a watermark: a promise that no later entry comes before a given timestamp.
+template<class T>
+class SubmissionRing
+{
+    public:
+    // Each group of members below gets a cache line of its own, so no line is written by one side per entry while
+    // the other side reads it
+    char padStart[64];
+    // Written by the consumer once per batch
+    atomic<ll> head;
+    char padHead[64];
+    // Read by the producer on every push, written only when the consumer finds the ring empty and when the
+    // producer publishes for it
+    atomic<bool> starved;
+    char padStarved[64];
+    // Consumer only
+    size_t readPos; // next entry of the batch at head
+    char padConsumer[64];
+    // Written by the producer once per batch
+    atomic<ll> tail;
+    atomic<bool> closed;
+    atomic<ll> watermark; // entries not published yet have a timestamp >= this
+    char padPublished[64];
+    // Producer only
+    vector<T> pending;
+    size_t batchSize;
+    char padProducer[64];
+    // Fixed after construction
+    vector< vector<T> > slots;
+    ll mask;
+    
+    // slotCount must be a power of two
+    SubmissionRing(ll slotCount,size_t batchSize)
+    {
+        slots.resize(slotCount);
+        mask = slotCount - 1;
+        this->batchSize = batchSize;
+        pending.reserve(batchSize);
+        head = 0;
+        starved = false;
+        tail = 0;
+        closed = false;
+        watermark = 0;
+        readPos = 0;
+    }
+    
+    // Producer: queues an entry, publishing the batch once it is full or the consumer is waiting for it
+    void push(const T &entry)
+    {
+        pending.push_back(entry);
+        if(pending.size() == batchSize)
+            publish();
+        else if(starved.load(memory_order_relaxed))
+        {
+            starved.store(false,memory_order_relaxed);
+            publish();
+        }
+    }
+    
+    // Producer: publishes what is pending and promises that every later entry has a timestamp >= timestamp,
+    // so the consumer need not wait for this producer to hand on earlier entries of other producers
+    void advance(ll timestamp)
+    {
+        publish();
+        watermark.store(timestamp,memory_order_release);
+    }
+    
+    // Producer: hands the current batch to the consumer, waiting while every slot is taken
+    void publish()
+    {
+        if(pending.empty())
+            return;
+        ll t = tail.load(memory_order_relaxed);
+        while(t - head.load(memory_order_acquire) > mask)
+            this_thread::yield();
+        slots[t & mask].swap(pending);
+        tail.store(t + 1,memory_order_release);
+        pending.reserve(batchSize);
+    }
+    
+    // Producer: publishes what is left, no entry may be pushed after this
+    void close()
+    {
+        publish();
+        closed.store(true,memory_order_release);
+    }
+    
+    // Consumer: the next entry or NULL if none has been published yet. finished is set once the producer has
+    // closed and every entry has been read.
+    T *front(bool &finished)
+    {
+        finished = false;
+        ll h = head.load(memory_order_relaxed);
+        while(true)
+        {
+            if(h == tail.load(memory_order_acquire))
+            {
+                // tail is read again since entries published before closing are only seen after it
+                if(!closed.load(memory_order_acquire))
+                    return NULL;
+                if(h == tail.load(memory_order_acquire))
+                {
+                    finished = true;
+                    return NULL;
+                }
+                continue;
+            }
+            vector<T> &batch = slots[h & mask];
+            if(readPos < batch.size())
+                return &batch[readPos];
+            // Batch read, give its slot back
+            batch.clear();
+            readPos = 0;
+            head.store(++h,memory_order_release);
+        }
+    }
+    
+    // Consumer: moves past the entry returned by front
+    void pop()
+    {
+        readPos++;
+    }
+};
+
+// Merges the rings of several producers into one stream of jobs in timestamp order, for a single thread to feed
+// to the scheduler. Each producer submits its own jobs in non-decreasing timestamp order. A job is handed on only
+// once no earlier job can still come: every producer that has not closed has a job waiting, or a watermark past it
+// (SubmissionRing::advance). Ties go to the producer with the lower index, which makes the order (and the job IDs)
+// the same on every run.
+class JobSubmission
+{
+    public:
+    vector< SubmissionRing<SubmittedJob>* > rings;
+    // (timestamp, producer) of the first waiting job of every producer still open
+    priority_queue< pair<ll,ll>,vector< pair<ll,ll> >,greater< pair<ll,ll> > > heads;
+    // Producers still open with no job waiting, and their watermark when that was last seen
+    vector< pair<ll,ll> > idle;
+    bool started;
+    
+    JobSubmission(ll producers,ll slotCount = 64,size_t batchSize = 256)
+    {
+        for(ll i=0; i<producers; i++)
+            rings.push_back(new SubmissionRing<SubmittedJob>(slotCount,batchSize));
+        started = false;
+    }
+    ~JobSubmission()
+    {
+        for(size_t i=0; i<rings.size(); i++)
+            delete rings[i];
+    }
+    
+    // Ring that producer thread i pushes its jobs into
+    SubmissionRing<SubmittedJob> &producer(ll i)
+    {
+        return *rings[i];
+    }
+    
+    // Adds the next job of producer i to heads, or the producer to idle if it has none yet, in which case it
+    // publishes what it has from its next push on. The watermark is read first: whatever was published before it
+    // was set is then seen by front.
+    void pollProducer(ll i)
+    {
+        SubmissionRing<SubmittedJob> &ring = *rings[i];
+        ll watermark = ring.watermark.load(memory_order_acquire);
+        bool finished;
+        SubmittedJob *job = ring.front(finished);
+        if(job != NULL)
+            heads.push(make_pair(job->timestamp,i));
+        else if(!finished)
+        {
+            if(!ring.starved.load(memory_order_relaxed))
+                ring.starved.store(true,memory_order_relaxed);
+            idle.push_back(make_pair(watermark,i));
+        }
+    }
+    
+    // True if an idle producer could still submit a job that goes before the first waiting one
+    bool blockedByIdle()
+    {
+        for(size_t k=0; k<idle.size(); k++)
+            if(heads.empty() || idle[k].first < heads.top().first || (idle[k].first == heads.top().first && idle[k].second < heads.top().second))
+                return true;
+        return false;
+    }
+    
+    // Next job in timestamp order, false once every producer has closed
+    bool next(SubmittedJob &job)
+    {
+        if(!started)
+        {
+            for(size_t i=0; i<rings.size(); i++)
+                pollProducer(i);
+            started = true;
+        }
+        while(blockedByIdle())
+        {
+            this_thread::yield();
+            vector< pair<ll,ll> > waiting;
+            waiting.swap(idle);
+            for(size_t k=0; k<waiting.size(); k++)
+                pollProducer(waiting[k].second);
+        }
+        if(heads.empty())
+            return false;
+        ll i = heads.top().second;
+        heads.pop();
+        bool finished;
+        job = move(*rings[i]->front(finished));
+        rings[i]->pop();
+        pollProducer(i);
+        return true;
+    }
+};
+
+
+// Parts of the scheduler timed by '--profile' (see PROFILING)
+enum ProfilePhase
+{
+    PHASE_PARSE,
+    PHASE_AGING,
+    PHASE_HEAP_INSERT,
+    PHASE_DURATION_HEAPS,
+    PHASE_MAXMINS,
+    PHASE_CPU_TREE,
+    PHASE_QUEUE_EXTRACT,
+    PHASE_HISTORY_SCAN,
+    PHASE_OUTPUT,
+    PHASE_INDEX,
+    PHASE_STORAGE,
+    PHASE_HISTORY,
+    PHASE_COUNT
+};
+const char *PHASE_NAMES[PHASE_COUNT] = {"parse","aging","heap_insert","duration_heaps","maxmins","cpu_tree",
+    "queue_extract","history_scan","output","index","storage","history"};
+
+// Time stamp counter, or a steady clock in nanoseconds where there is none
+inline ll readCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Cost of one command of the trace and what drove it
+struct CommandProfile
+{
+    ll line;
+    string text;
+    string operation;
+    ll cycles;
+    ll phaseCycles[PHASE_COUNT];
+    ll k; // K of 'assign' and of a top-K 'query'
+    ll window; // span of waiting timestamps a query had to look through
+    ll buckets; // importance buckets visited
+    ll blocks; // history blocks decoded
+    ll jobs; // jobs assigned or printed
+    CommandProfile()
+    {
+        line = 0;
+        cycles = 0;
+        for(int i=0; i<PHASE_COUNT; i++)
+            phaseCycles[i] = 0;
+        k = 0;
+        window = 0;
+        buckets = 0;
+        blocks = 0;
+        jobs = 0;
+    }
+    bool operator>(const CommandProfile &other) const
+    {
+        return cycles > other.cycles;
+    }
+};
+
+// Totals of one kind of command
+struct OperationProfile
+{
+    ll count;
+    ll cycles;
+    ll phaseCycles[PHASE_COUNT];
+    OperationProfile()
+    {
+        count = 0;
+        cycles = 0;
+        for(int i=0; i<PHASE_COUNT; i++)
+            phaseCycles[i] = 0;
+    }
+};
+
+// Collects per-phase totals per kind of command and keeps the slowest commands in a min-heap of size topN
+class CommandProfiler
+{
+    public:
+    CommandProfile current;
+    ll start;
+    int openPhase; // innermost phase being timed, -1 if none
+    map<string,OperationProfile> operations;
+    vector<CommandProfile> slowest;
+    ll topN;
+    
+    CommandProfiler(ll topN)
+    {
+        this->topN = topN;
+        start = 0;
+        openPhase = -1;
+    }
+    
+    void beginCommand(ll line,const char *text)
+    {
+        openPhase = -1;
+        current = CommandProfile();
+        current.line = line;
+        current.text = text;
+        while(current.text.size() && isspace((unsigned char)current.text[current.text.size()-1]))
+            current.text.erase(current.text.size()-1);
+        start = readCycles();
+    }
+    
+    void endCommand()
+    {
+        current.cycles = readCycles() - start;
+        if(current.operation.empty())
+            return;
+        OperationProfile &totals = operations[current.operation];
+        totals.count++;
+        totals.cycles += current.cycles;
+        for(int i=0; i<PHASE_COUNT; i++)
+            totals.phaseCycles[i] += current.phaseCycles[i];
+        if(topN == 0)
+            return;
+        if((ll)slowest.size() < topN)
+        {
+            slowest.push_back(current);
+            push_heap(slowest.begin(),slowest.end(),greater<CommandProfile>());
+        }
+        else if(current.cycles > slowest[0].cycles)
+        {
+            pop_heap(slowest.begin(),slowest.end(),greater<CommandProfile>());
+            slowest.back() = current;
+            push_heap(slowest.begin(),slowest.end(),greater<CommandProfile>());
+        }
+    }
+    
+    // Writes a field in quotes, doubling the quotes in it (RFC 4180). Unless always is set the quotes are only added
+    // when the field holds a comma, quote or line break.
+    static void writeCSVField(FILE *out,const string &field,bool always)
+    {
+        if(!always && field.find_first_of(",\"\r\n") == string::npos)
+        {
+            fputs(field.c_str(),out);
+            return;
+        }
+        fputc('"',out);
+        for(size_t i=0; i<field.size(); i++)
+        {
+            if(field[i] == '"')
+                fputc('"',out);
+            fputc(field[i],out);
+        }
+        fputc('"',out);
+    }
+    
+    void writeCSVRow(FILE *out,const char *kind,const string &operation,ll line,ll count,ll cycles,const ll *phaseCycles,const CommandProfile *command)
+    {
+        fprintf(out,"%s,",kind);
+        writeCSVField(out,operation,false);
+        fputc(',',out);
+        if(command != NULL && line > 0)
+            fprintf(out,"%llu",line);
+        fprintf(out,",%llu,%llu",count,cycles);
+        for(int i=0; i<PHASE_COUNT; i++)
+            fprintf(out,",%llu",phaseCycles[i]);
+        if(command != NULL)
+        {
+            fprintf(out,",%llu,%llu,%llu,%llu,%llu,",command->k,command->window,command->buckets,command->blocks,command->jobs);
+            writeCSVField(out,command->text,true);
+            fputc('\n',out);
+        }
+        else fprintf(out,",,,,,,\n");
+    }
+    
+    // <prefix>.csv: a 'total' row per kind of command, then the slowest commands
+    // <prefix>.folded: "operation;phase cycles" lines for flame graph tools, time outside the phases on "operation"
+    bool writeReports(const string &prefix)
+    {
+        FILE *csv = fopen((prefix + ".csv").c_str(),"w");
+        FILE *folded = fopen((prefix + ".folded").c_str(),"w");
+        if(csv == NULL || folded == NULL)
+        {
+            fprintf(stderr,"cannot write the profile to %s.csv and %s.folded\n",prefix.c_str(),prefix.c_str());
+            if(csv)
+                fclose(csv);
+            if(folded)
+                fclose(folded);
+            return false;
+        }
+        fprintf(csv,"kind,operation,line,count,cycles");
+        for(int i=0; i<PHASE_COUNT; i++)
+            fprintf(csv,",%s",PHASE_NAMES[i]);
+        fprintf(csv,",k,window,buckets,blocks,jobs,command\n");
+        
+        for(map<string,OperationProfile>::iterator it=operations.begin(); it!=operations.end(); ++it)
+        {
+            OperationProfile &totals = it->second;
+            writeCSVRow(csv,"total",it->first,0,totals.count,totals.cycles,totals.phaseCycles,NULL);
+            ll inPhases = 0;
+            for(int i=0; i<PHASE_COUNT; i++)
+            {
+                inPhases += totals.phaseCycles[i];
+                if(totals.phaseCycles[i] > 0)
+                    fprintf(folded,"%s;%s %llu\n",it->first.c_str(),PHASE_NAMES[i],totals.phaseCycles[i]);
+            }
+            if(totals.cycles > inPhases)
+                fprintf(folded,"%s %llu\n",it->first.c_str(),totals.cycles - inPhases);
+        }
+        
+        sort_heap(slowest.begin(),slowest.end(),greater<CommandProfile>());
+        for(size_t i=0; i<slowest.size(); i++)
+            writeCSVRow(csv,"slowest",slowest[i].operation,slowest[i].line,1,slowest[i].cycles,slowest[i].phaseCycles,&slowest[i]);
+        fclose(csv);
+        fclose(folded);
+        return true;
+    }
+};
+
+// Adds the cycles from construction until stop() or the end of the scope to a phase of the current command.
+// A timer started while another one runs takes its cycles out of the outer phase, so nothing is counted twice.
+// Costs a single test when profiling is off.
+class PhaseTimer
+{
+    public:
+    CommandProfiler *profiler;
+    ProfilePhase phase;
+    int outerPhase;
+    ll start;
+    PhaseTimer(CommandProfiler *profiler,ProfilePhase phase)
+    {
+        this->profiler = profiler;
+        this->phase = phase;
+        if(profiler)
+        {
+            outerPhase = profiler->openPhase;
+            profiler->openPhase = phase;
+            start = readCycles();
+        }
+    }
+    ~PhaseTimer()
+    {
+        stop();
+    }
+    void stop()
+    {
+        if(profiler == NULL)
+            return;
+        ll cycles = readCycles() - start;
+        profiler->current.phaseCycles[phase] += cycles;
+        if(outerPhase >= 0)
+            profiler->current.phaseCycles[outerPhase] -= cycles;
+        profiler->openPhase = outerPhase;
+        profiler = NULL;
+    }
+};
+
+
+// Complete scheduler state for one choice of key widths.
+// IdT   : type of job IDs (heap entries, history buckets)
+// TimeT : type of timestamps, stored relative to 'epoch'
+// DurT  : type of job durations
+// LEVELS: number of importance buckets (valid importances are 1 .. LEVELS-1)
+// QueueT: job queue backend used for the waiting jobs of each importance bucket
+template<typename IdT,typename TimeT,typename DurT,int LEVELS,template<typename,class> class QueueT>
+class Scheduler
+{
+    public:
+    typedef Job<IdT,TimeT,DurT> JobT;
+    
+    // Priority order handed to the job queues
+    struct JobPriority
+    {
+        Scheduler *scheduler;
+        JobPriority() {}
+        JobPriority(Scheduler *scheduler)
+        {
+            this->scheduler = scheduler;
+        }
+        bool operator()(IdT jID1,IdT jID2) const
+        {
+            return scheduler->hasHigherPriority(jID1,jID2);
+        }
+        ll arrival(IdT jobID) const
+        {
+            return scheduler->jobList[jobID].timestamp;
+        }
+        IdT &position(IdT jobID) const
+        {
+            return scheduler->heapPositions[jobID];
+        }
+    };
+    
+    // Identifies a job by its processID and timestamp for 'cancel'
+    struct JobKey
+    {
+        ll processID;
+        TimeT timestamp;
+        JobKey(ll processID,TimeT timestamp)
+        {
+            this->processID = processID;
+            this->timestamp = timestamp;
+        }
+        bool operator==(const JobKey &other) const
+        {
+            return processID == other.processID && timestamp == other.timestamp;
+        }
+    };
+    struct JobKeyHash
+    {
+        size_t operator()(const JobKey &key) const
+        {
+            return hash<ll>()(key.processID * 0x9E3779B97F4A7C15ULL ^ key.timestamp);
+        }
+    };
+    typedef QueueT<IdT,JobPriority> Queue;
+    typedef CPUNode<TimeT,IdT> Node;
+    
+    // Entries per sealed history block
+    static const int HISTORY_BLOCK_SIZE = 128;
+    typedef HistoryBucket<IdT,TimeT,HISTORY_BLOCK_SIZE> Bucket;
+    
+    // qExit of a job that is still waiting in the queue
+    static const TimeT NOT_EXITED = numeric_limits<TimeT>::max();
+    static const IdT NO_JOB = numeric_limits<IdT>::max();
+    
+    // Maps Job ID to Job Class
+    ChunkedList<JobT> jobList;
+    NameTable origins;
+    StringArena instructions;
+    ll expectedJobs; // job chunks allocated on 'cpus', 0 to allocate as jobs come in
+    
+    // Partition of jobs seen so far based on importance
+    Bucket qJobList[LEVELS];
+    vector<IdT> durationHeaps[LEVELS];  // Heaps to store durations for jobs with same timestamp and importance
+    TimeT prevTimestamps[LEVELS]; // Last seen timestamp by a duration heap
+    IdT durationHeapSize[LEVELS]; // Sizes of duration heaps
+    ll totalSize; //Total jobs pending to be inserted
+    
+    // Vector of MaxMinNodes, one for each timestamp seen so far
+    ChunkedList< MaxMinNode<TimeT> > MaxMins;
+    
+    // Priority Queue Of Jobs Waiting (partitioned on importance value)
+    Queue jobHeap[LEVELS];
+    ChunkedList<IdT> heapPositions; // slot of each job inside its queue, maintained by the queue
+    vector<IdT> assigned; // scratch space for assign
+    
+    // Fair-share mode: waiting jobs are queued per originSystem (in priority order within an origin) instead of
+    // per importance, and 'assign' takes jobs from the origins by deficit round robin. An origin gets 'weight'
+    // jobs per turn, origins without waiting jobs drop out of the round and rejoin at its end.
+    struct FairShareOrigin
+    {
+        Queue queue;
+        ll weight;
+        ll deficit; // jobs left in its current turn
+        bool inRound;
+    };
+    bool fairShare;
+    deque<FairShareOrigin> fairOrigins; // by index in origins, added when first needed
+    deque<unsigned int> fairRound;
+    
+    // Jobs waiting in the queue by (processID, timestamp)
+    typedef unordered_multimap<JobKey,IdT,JobKeyHash> WaitingIndex;
+    WaitingIndex waitingIndex;
+    // In low-jitter mode the index is not rehashed in one go when it fills up: new entries go to a table twice
+    // the size and the old entries are moved over a slice at a time, lookups check both until it is done.
+    WaitingIndex growingIndex;
+    bool indexGrowing;
+    
+    // Low-jitter mode: deferred work is done at most jitterBudget entries per command (0 does it all at once).
+    // Closed duration heaps wait here, in order, to be moved into qJobList.
+    struct PendingFlush
+    {
+        int importance;
+        vector<IdT> heap;
+        IdT size;
+    };
+    ll jitterBudget;
+    deque<PendingFlush> pendingFlushes;
+    
+    // Where a job was in history after it left the bucket it was submitted to (at Job::bucketExit).
+    // A stay starts at each reprioritize or at the first aging promotion. While aging is on, the importance
+    // goes up by one every ageInterval after 'from', so further promotions need no new stay.
+    struct BucketStay
+    {
+        TimeT timestamp;
+        DurT duration;
+        IdT jobID;
+        TimeT from;
+        TimeT until; // NOT_EXITED while the job is still waiting
+        unsigned short importance; // importance at 'from'
+        bool aging;
+    };
+    ChunkedList<BucketStay> movedStays; // in the order they were opened
+    // Stays are indexed in groups a query takes one importance at a time (see collectMovedStays).
+    // Without aging a group holds the stays of an importance. With aging a stay's importance at T is
+    // F - c or F - c - 1, with F = min(T,agedUntil)/ageInterval and group c = from/ageInterval - importance.
+    // Stays at the top importance are also indexed from the time they got there, as F - c no longer applies.
+    map<long long,IntervalIndex<TimeT> > stayGroups;
+    IntervalIndex<TimeT> topStays;
+    struct OpenStay
+    {
+        ll index; // in movedStays
+        ll groupPos;
+        long long topPos; // -1 until it reaches the top importance
+    };
+    unordered_map<IdT,OpenStay> currentStay; // for waiting jobs that were moved
+    vector<const BucketStay*> movedScratch;
+    vector<ll> openStayScratch;
+    
+    // Aging: a waiting job moves up one importance level every ageInterval time units (0 disables aging)
+    ll ageInterval;
+    // Next promotion time of waiting jobs. Entries of jobs that left the queue or were rescheduled
+    // (nextAging no longer matches) are dropped when they come up.
+    priority_queue< pair<TimeT,IdT>,vector< pair<TimeT,IdT> >,greater< pair<TimeT,IdT> > > agingQueue;
+    ChunkedList<TimeT> nextAging;
+    TimeT agedUntil; // promotions due up to here have been applied
+    
+    // Offline batch mode: queries are only recorded while the trace is simulated and are answered
+    // afterwards in a single sweep over time, once every qExit is known
+    struct OfflineQuery
+    {
+        TimeT timestamp;
+        ll K;
+        string origin; // empty for a top K query
+        ll outputOffset; // simulation output written before the query
+        vector< pair<IdT,unsigned short> > result;
+    };
+    bool offline;
+    vector<OfflineQuery> offlineQueries;
+    
+    // Interval of time a job spent in one importance bucket
+    struct HistorySegment
+    {
+        TimeT start,end;
+        IdT jobID;
+        unsigned short importance;
+    };
+    
+    // Waiting job in the sweep, in priority order
+    struct LiveJob
+    {
+        unsigned short importance;
+        TimeT timestamp;
+        DurT duration;
+        IdT jobID;
+        bool operator<(const LiveJob &other) const
+        {
+            if(importance != other.importance)
+                return importance > other.importance;
+            if(timestamp != other.timestamp)
+                return timestamp < other.timestamp;
+            if(duration != other.duration)
+                return duration < other.duration;
+            return jobID < other.jobID;
+        }
+    };
+    
+    // Create BST To Store CPU Free Times
+    Node *cpuTreeRoot;
+    // Phase timers of '--profile', NULL when not profiling
+    CommandProfiler *profiler;
+    
+    // Versions of it for 'cpuquery', using at most cpuHistoryCap bytes (0 keeps none)
+    CPUHistory<TimeT,IdT> cpuHistory;
+    ll cpuHistoryCap;
+    
+    // Stores timestamps of jobs waiting in queue as a Priority Queue
+    Node *startTimeRoot;
+    
+    IdT ID; //Dummmy Variable acting as ID
+    TimeT prevTimestamp; // last seen timestamp
+    
+    // Narrow variants store timestamps relative to the first timestamp seen
+    ll epoch;
+    bool epochSet;
+    
+    Scheduler()
+    {
+        for(int i=0; i<LEVELS; i++)
+        {
+            prevTimestamps[i] = 0;
+            durationHeapSize[i] = 0;
+            jobHeap[i].setCompare(JobPriority(this));
+        }
+        totalSize = 0;
+        cpuTreeRoot = NULL;
+        startTimeRoot = NULL;
+        ID = 0;
+        prevTimestamp = 0;
+        epoch = 0;
+        epochSet = false;
+        ageInterval = 0;
+        agedUntil = 0;
+        offline = false;
+        expectedJobs = 0;
+        jitterBudget = 0;
+        indexGrowing = false;
+        fairShare = false;
+        cpuHistoryCap = 0;
+        profiler = NULL;
+    }
+    
+    void reportOverflow(const char *what,ll value)
+    {
+        fprintf(stderr,"%s %llu does not fit the %d-bit scheduler, rerun with --width=64\n",what,value,(int)(8*sizeof(TimeT)));
+        exit(1);
+    }
+    
+    void reportOutOfRange(const char *what,ll value,ll low,ll high)
+    {
+        fprintf(stderr,"%s %llu is not between %llu and %llu\n",what,value,low,high);
+        exit(1);
+    }
+    
+    TimeT toRelativeTime(ll timestamp)
+    {
+        if(!epochSet)
+        {
+            epoch = (sizeof(TimeT) < sizeof(ll)) ? timestamp : 0;
+            epochSet = true;
+        }
+        if(timestamp < epoch || timestamp - epoch >= NOT_EXITED)
+            reportOverflow("timestamp",timestamp);
+        return timestamp - epoch;
+    }
+    
+    bool hasHigherPriority(IdT jID1,IdT jID2)
+    {
+        const JobT &j1 = jobList[jID1];
+        const JobT &j2 = jobList[jID2];
+        if(j1.importance > j2.importance)
+            return true;
+        if(j1.importance < j2.importance)
+            return false;
+        if(j1.timestamp < j2.timestamp)
+            return true;
+        if(j1.timestamp > j2.timestamp)
+            return false;
+        if(j1.duration < j2.duration)
+             return true;
+        if(j1.duration > j2.duration)
+             return false;
+        return jID1 < jID2; // Complete ties go to the job that came in first
+    }
+    
+    // Order of jobs with one importance and timestamp in history, the same as in hasHigherPriority
+    bool hasShorterDuration(IdT jID1,IdT jID2)
+    {
+        if(jobList[jID1].duration != jobList[jID2].duration)
+            return jobList[jID1].duration < jobList[jID2].duration;
+        return jID1 < jID2;
+    }
+    
+    void maxHeapify_Duration(vector<IdT> &jobHeap,IdT pos,IdT jobHeapSize)
+    {
+        IdT maxPos = pos;
+        ll left = getLeft(pos);
+        ll right = getRight(pos);
+        
+        if(left < jobHeapSize && hasShorterDuration(jobHeap[left],jobHeap[maxPos]))
+            maxPos = left;
+        if(right < jobHeapSize && hasShorterDuration(jobHeap[right],jobHeap[maxPos]))
+            maxPos = right;
+        
+        if(maxPos != pos)
+        {
+            IdT tempJobID = jobHeap[maxPos];
+            jobHeap[maxPos] = jobHeap[pos];
+            jobHeap[pos] = tempJobID;
+            maxHeapify_Duration(jobHeap,maxPos,jobHeapSize);
+        }
+        
+    }
+    
+    IdT extractNextID(vector<IdT> &jobHeap,IdT &jobHeapSize)
+    {
+        IdT jobID = jobHeap[0];
+        
+        if(jobHeapSize == 1)
+        {
+            jobHeapSize = 0;
+            return jobID;
+        }
+        jobHeapSize--;
+        jobHeap[0] = jobHeap[jobHeapSize];
+        maxHeapify_Duration(jobHeap,0,jobHeapSize);
+        return jobID;
+    }
+    
+    void insertIntoDurationHeap(IdT jobID,vector<IdT> &jobHeap,IdT &jobHeapSize)
+    {
+        totalSize++;
+        if(jobHeapSize + 1 > jobHeap.size())
+            jobHeap.push_back(jobID);
+        else jobHeap[jobHeapSize] = jobID;
+        
+        IdT pos = jobHeapSize;
+        jobHeapSize++;
+        
+        while(1)
+        {
+            if(pos == 0)
+                break;
+            IdT parent = getParent(pos);
+            if(hasShorterDuration(jobHeap[pos],jobHeap[parent]))
+            {
+                jobHeap[pos] = jobHeap[parent];
+                jobHeap[parent] = jobID;
+                pos = parent;
+            }
+            else break;
+        }   
+    }
+    
+    
+    void emptyOutDurationHeap(int importance)
+    {
+        if(durationHeapSize[importance] == 0)
+            return;
+        totalSize -= durationHeapSize[importance];
+        while(durationHeapSize[importance])
+            appendToHistory(extractNextID(durationHeaps[importance],durationHeapSize[importance]),importance);
+    }
+    
+    void appendToHistory(IdT jobID,int importance)
+    {
+        jobList[jobID].historyPos = qJobList[importance].size();
+        qJobList[importance].push_back(jobID,jobList[jobID].timestamp,jobList[jobID].bucketExit);
+    }
+    
+    void emptyOutAllDurationHeaps()
+    {
+        for(int i=1; i<LEVELS; i++)
+            emptyOutDurationHeap(i);
+    }
+    
+    // Ends the duration heap of a bucket because a later timestamp was seen. In low-jitter mode the heap is
+    // handed over to pendingFlushes in O(1) and moved into history by doDeferredWork.
+    void closeDurationHeap(int importance)
+    {
+        if(jitterBudget == 0)
+        {
+            emptyOutDurationHeap(importance);
+            return;
+        }
+        if(durationHeapSize[importance] == 0)
+            return;
+        pendingFlushes.emplace_back();
+        PendingFlush &flush = pendingFlushes.back();
+        flush.importance = importance;
+        flush.size = durationHeapSize[importance];
+        flush.heap.swap(durationHeaps[importance]);
+        // The next timestamp is likely to bring as many jobs, so it starts with the capacity this one needed
+        durationHeaps[importance].reserve(flush.heap.capacity());
+        totalSize -= durationHeapSize[importance];
+        durationHeapSize[importance] = 0;
+    }
+    
+    void closeAllDurationHeaps()
+    {
+        for(int i=1; i<LEVELS; i++)
+            closeDurationHeap(i);
+    }
+    
+    // Entries of the index moved per command while it grows, whatever the flush backlog
+    ll indexShare()
+    {
+        return (jitterBudget + 1)/2;
+    }
+    
+    // Does up to budget entries of deferred work. While the index grows it gets indexShare() of the budget, so it
+    // is done before the new table fills up (see addToWaitingIndex); the duration heaps get the rest and each side
+    // gets what the other leaves.
+    void doDeferredWork(ll budget)
+    {
+        ll indexBudget = indexGrowing ? indexShare() : 0;
+        budget -= indexBudget;
+        PhaseTimer flushTimer(profiler,PHASE_DURATION_HEAPS);
+        flushPending(budget);
+        flushTimer.stop();
+        indexBudget += budget;
+        PhaseTimer indexTimer(profiler,PHASE_INDEX);
+        growIndex(indexBudget);
+        indexTimer.stop();
+        PhaseTimer leftoverTimer(profiler,PHASE_DURATION_HEAPS);
+        flushPending(indexBudget);
+    }
+    
+    // Moves up to budget jobs of the pending duration heaps into qJobList, budget is left with what was not used
+    void flushPending(ll &budget)
+    {
+        while(budget > 0 && pendingFlushes.size())
+        {
+            PendingFlush &flush = pendingFlushes.front();
+            for(; budget > 0 && flush.size > 0; budget--)
+                appendToHistory(extractNextID(flush.heap,flush.size),flush.importance);
+            if(flush.size == 0)
+                pendingFlushes.pop_front();
+        }
+    }
+    
+    // Moves up to budget entries of the waiting index to the larger table, budget is left with what was not used
+    void growIndex(ll &budget)
+    {
+        for(; budget > 0 && indexGrowing; budget--)
+        {
+            if(waitingIndex.size() == 0)
+            {
+                waitingIndex.swap(growingIndex);
+                WaitingIndex().swap(growingIndex);
+                indexGrowing = false;
+                break;
+            }
+            growingIndex.insert(*waitingIndex.begin());
+            waitingIndex.erase(waitingIndex.begin());
+        }
+    }
+    
+    // Everything a history query needs, regardless of the budget
+    void finishPendingFlushes()
+    {
+        while(pendingFlushes.size())
+        {
+            PendingFlush &flush = pendingFlushes.front();
+            while(flush.size > 0)
+                appendToHistory(extractNextID(flush.heap,flush.size),flush.importance);
+            pendingFlushes.pop_front();
+        }
+    }
+    
+    // Last entry with a timestamp <= timestamp, which must not be before MaxMins[left]
+    ll doBinarySearchMaxMins(TimeT timestamp,ll left,ll right)
+    {
+        if(MaxMins[right].timestamp <= timestamp)
+            return right;
+        ll mid = (left + right)/2;
+        if(MaxMins[mid].timestamp <= timestamp)
+        {
+            if(MaxMins[mid+1].timestamp <= timestamp)
+                    return doBinarySearchMaxMins(timestamp,mid+1,right);
+            return mid;
+        }
+        return doBinarySearchMaxMins(timestamp,left,mid-1);
+    }
+    
+    // First position in the bucket with timestamp >= value, whole blocks are skipped using their headers
+    ll getStartPoint(TimeT value,Bucket &bucket)
+    {
+        return bucket.getBoundary(value,false);
+    }
+    
+    // Last position in the bucket with timestamp <= value
+    ll getEndPoint(TimeT value,Bucket &bucket)
+    {
+        return bucket.getBoundary(value,true) - 1;
+    }
+    
+    
+    
+    // What a history query had to look through, for '--profile'
+    void profileScan(TimeT Min,TimeT Max,ll buckets,ll blocks,ll selected)
+    {
+        profiler->current.window = Max - Min;
+        profiler->current.buckets = buckets;
+        profiler->current.blocks = blocks;
+        profiler->current.jobs = selected;
+    }
+    
+    void printHistory_TOPK(TimeT timestamp,ll K)
+    {
+        ll selected = 0;
+        int importance = LEVELS - 1;
+        ll tsNearbyIndex = doBinarySearchMaxMins(timestamp,0,MaxMins.size()-1);
+        TimeT Min = MaxMins[tsNearbyIndex].Min;
+        TimeT Max = MaxMins[tsNearbyIndex].Max;
+        if(Max < Min)
+            return;
+        
+        IdT jobIDs[HISTORY_BLOCK_SIZE];
+        TimeT timestamps[HISTORY_BLOCK_SIZE];
+        vector<const BucketStay*> &moved = movedScratch;
+        ll bucketsVisited = 0,blocksDecoded = 0;
+        
+        while(selected < K && importance != 0)
+        {
+            int bucketImportance = importance--;
+            Bucket &bucket = qJobList[bucketImportance];
+            
+            // Jobs that were in this bucket at timestamp after a reprioritize or aging are merged into the scan
+            collectMovedStays(timestamp,bucketImportance,K - selected,NULL,moved);
+            ll nextMoved = 0,movedEnd = moved.size();
+            
+            if(bucket.size() > 0 && Max >= bucket.firstTimestamp() && Min <= bucket.lastTimestamp())
+            {
+                bucketsVisited++;
+                ll left = getStartPoint(Min,bucket);
+                ll right = getEndPoint(Max,bucket);
+                
+                // Scan a block at a time, skipping blocks where every job had left the bucket by timestamp
+                bool done = false;
+                for(ll start=bucket.nextLiveBlock(bucket.blockStart(left),timestamp); start<=right && !done; start=bucket.nextLiveBlock(start+HISTORY_BLOCK_SIZE,timestamp))
+                {
+                    ll count = bucket.decodeBlock(start,jobIDs,timestamps);
+                    blocksDecoded++;
+                    for(ll k=max(left,start)-start,l=min(right-start,count-1); k<=l; ++k)
+                    {
+                        JobT &job = jobList[jobIDs[k]];
+                        if(timestamps[k] <= timestamp && timestamp < job.bucketExit)
+                        {
+                            // Jobs moved into this bucket that come before this one
+                            for(; nextMoved < movedEnd && selected < K && stayComesFirst(*moved[nextMoved],timestamps[k],job,jobIDs[k]); nextMoved++,selected++)
+                                printJob(moved[nextMoved]->jobID,bucketImportance);
+                            if(selected < K)
+                            {
+                                printJob(jobIDs[k],bucketImportance);
+                                selected++;
+                            }
+                        }
+                        if(timestamps[k] > timestamp || selected == K)
+                        {
+                            done = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            
+            for(; nextMoved < movedEnd && selected < K; nextMoved++,selected++)
+                printJob(moved[nextMoved]->jobID,bucketImportance);
+        }
+        
+        if(profiler)
+            profileScan(Min,Max,bucketsVisited,blocksDecoded,selected);
+    }
+    
+    void printHistory_Origin(TimeT timestamp,const string &originSystem)
+    {
+        // An origin that never sent a job gets an index no job has
+        unsigned int origin = origins.find(originSystem);
+        ll selected = 0;
+        int importance = LEVELS - 1;
+        ll tsNearbyIndex = doBinarySearchMaxMins(timestamp,0,MaxMins.size()-1);
+        TimeT Min = MaxMins[tsNearbyIndex].Min;
+        TimeT Max = MaxMins[tsNearbyIndex].Max;
+        
+        if(Max < Min)
+            return;
+        
+        IdT jobIDs[HISTORY_BLOCK_SIZE];
+        TimeT timestamps[HISTORY_BLOCK_SIZE];
+        vector<const BucketStay*> &moved = movedScratch;
+        ll bucketsVisited = 0,blocksDecoded = 0;
+        
+        while(importance != 0)
+        {
+            int bucketImportance = importance--;
+            Bucket &bucket = qJobList[bucketImportance];
+            
+            // Jobs that were in this bucket at timestamp after a reprioritize or aging are merged into the scan
+            collectMovedStays(timestamp,bucketImportance,0,&origin,moved);
+            ll nextMoved = 0,movedEnd = moved.size();
+            
+            if(bucket.size() > 0 && Max >= bucket.firstTimestamp() && Min <= bucket.lastTimestamp())
+            {
+                bucketsVisited++;
+                ll left = getStartPoint(Min,bucket);
+                ll right = getEndPoint(Max,bucket);
+                
+                // Scan a block at a time, skipping blocks where every job had left the bucket by timestamp
+                bool done = false;
+                for(ll start=bucket.nextLiveBlock(bucket.blockStart(left),timestamp); start<=right && !done; start=bucket.nextLiveBlock(start+HISTORY_BLOCK_SIZE,timestamp))
+                {
+                    ll count = bucket.decodeBlock(start,jobIDs,timestamps);
+                    blocksDecoded++;
+                    for(ll k=max(left,start)-start,l=min(right-start,count-1); k<=l; ++k)
+                    {
+                        JobT &job = jobList[jobIDs[k]];
+                        if(timestamps[k] <= timestamp && timestamp < job.bucketExit && job.origin == origin)
+                        {
+                            // Jobs moved into this bucket that come before this one
+                            for(; nextMoved < movedEnd && stayComesFirst(*moved[nextMoved],timestamps[k],job,jobIDs[k]); nextMoved++,selected++)
+                                printJob(moved[nextMoved]->jobID,bucketImportance);
+                            printJob(jobIDs[k],bucketImportance);
+                            selected++;
+                        }
+                        if(timestamps[k] > timestamp)
+                        {
+                            done = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            
+            for(; nextMoved < movedEnd; nextMoved++,selected++)
+                printJob(moved[nextMoved]->jobID,bucketImportance);
+        }
+        
+        if(profiler)
+            profileScan(Min,Max,bucketsVisited,blocksDecoded,selected);
+    }
+    
+    int importanceAt(const BucketStay &stay,TimeT timestamp)
+    {
+        if(!stay.aging)
+            return stay.importance;
+        // Promotions that are not due yet are not reported
+        if(timestamp > agedUntil)
+            timestamp = agedUntil;
+        return min((ll)LEVELS - 1,stay.importance + (timestamp - stay.from)/ageInterval);
+    }
+    
+    // The order jobs are scanned in within a bucket
+    static bool stayBefore(const BucketStay *x,const BucketStay *y)
+    {
+        if(x->timestamp != y->timestamp)
+            return x->timestamp < y->timestamp;
+        if(x->duration != y->duration)
+            return x->duration < y->duration;
+        return x->jobID < y->jobID;
+    }
+    
+    long long stayGroup(const BucketStay &stay)
+    {
+        if(!stay.aging)
+            return stay.importance;
+        return (long long)(stay.from/ageInterval) - stay.importance;
+    }
+    
+    // Stays of jobs that were waiting at timestamp with the given importance then, in priority order.
+    // Only the first 'limit' are needed (0 for all). At most two groups are read and their max-trees skip
+    // the stays closed by then, so the cost follows the moved jobs waiting at timestamp near this importance.
+    void collectMovedStays(TimeT timestamp,int importance,ll limit,const unsigned int *origin,vector<const BucketStay*> &moved)
+    {
+        moved.clear();
+        vector<ll> &found = openStayScratch;
+        found.clear();
+        if(ageInterval > 0 && importance == LEVELS - 1)
+            topStays.findOpen(timestamp,found);
+        else
+        {
+            long long group = importance;
+            if(ageInterval > 0)
+                group = (long long)(min(timestamp,agedUntil)/ageInterval) - importance - 1;
+            for(int i=0; i<(ageInterval > 0 ? 2 : 1); i++)
+            {
+                typename map<long long,IntervalIndex<TimeT> >::iterator it = stayGroups.find(group + i);
+                if(it != stayGroups.end())
+                    it->second.findOpen(timestamp,found);
+            }
+        }
+        for(size_t i=0; i<found.size(); i++)
+        {
+            const BucketStay &stay = movedStays[found[i]];
+            if(importanceAt(stay,timestamp) == importance && (origin == NULL || jobList[stay.jobID].origin == *origin))
+                moved.push_back(&stay);
+        }
+        if(limit > 0 && (ll)moved.size() > limit)
+        {
+            partial_sort(moved.begin(),moved.begin() + limit,moved.end(),stayBefore);
+            moved.resize(limit);
+        }
+        else sort(moved.begin(),moved.end(),stayBefore);
+    }
+    
+    bool stayComesFirst(const BucketStay &stay,TimeT timestamp,const JobT &job,IdT jobID)
+    {
+        if(stay.timestamp != timestamp)
+            return stay.timestamp < timestamp;
+        if(stay.duration != job.duration)
+            return stay.duration < job.duration;
+        return stay.jobID < jobID;
+    }
+    
+    // Updating the max-min values after jobs left the queue at timestamp
+    void updateMaxMins(TimeT timestamp)
+    {
+        TimeT Max,Min;
+        if(startTimeRoot == NULL)
+        {
+            Max = 0;
+            Min = 1;
+        }
+        else
+        {
+            Max = getMaximum(startTimeRoot);        
+            Min = getMinimum(startTimeRoot);
+        }
+    
+        if(MaxMins.size() > 0 && MaxMins[MaxMins.size()-1].timestamp == timestamp)
+            MaxMins[MaxMins.size()-1] = MaxMinNode<TimeT>(Min,Max,timestamp);
+        else MaxMins.push_back(MaxMinNode<TimeT>(Min,Max,timestamp));
+    }
+    
+    void addToWaitingIndex(IdT jobID)
+    {
+        const JobT &job = jobList[jobID];
+        if(jitterBudget > 0 && !indexGrowing && waitingIndex.size() + 1 > waitingIndex.bucket_count()*waitingIndex.max_load_factor())
+        {
+            // The insert would rehash every entry, start moving them to a larger table instead. Each 'job' adds
+            // at most one entry and moves indexShare() of the old ones, so the table is sized for both and never
+            // rehashes before the old entries are all moved.
+            ll entries = waitingIndex.size();
+            growingIndex.reserve(max(entries + entries/indexShare() + 2,2*entries));
+            indexGrowing = true;
+        }
+        (indexGrowing ? growingIndex : waitingIndex).insert(make_pair(JobKey(job.processID,job.timestamp),jobID));
+    }
+    
+    bool eraseFromIndex(WaitingIndex &index,IdT jobID)
+    {
+        const JobT &job = jobList[jobID];
+        pair<typename WaitingIndex::iterator,typename WaitingIndex::iterator> range;
+        range = index.equal_range(JobKey(job.processID,job.timestamp));
+        for(typename WaitingIndex::iterator it = range.first; it != range.second; ++it)
+            if(it->second == jobID)
+            {
+                index.erase(it);
+                return true;
+            }
+        return false;
+    }
+    
+    void removeFromWaitingIndex(IdT jobID)
+    {
+        if(!eraseFromIndex(waitingIndex,jobID))
+            eraseFromIndex(growingIndex,jobID);
+    }
+    
+    void findInIndex(WaitingIndex &index,ll processID,TimeT timestamp,IdT &best)
+    {
+        pair<typename WaitingIndex::iterator,typename WaitingIndex::iterator> range;
+        range = index.equal_range(JobKey(processID,timestamp));
+        for(typename WaitingIndex::iterator it = range.first; it != range.second; ++it)
+            if(it->second < best)
+                best = it->second;
+    }
+    
+    // Waiting job with the given processID and timestamp, the first one submitted if there are several.
+    // NO_JOB if there is none.
+    IdT findWaitingJob(ll processID,TimeT timestamp)
+    {
+        IdT best = NO_JOB;
+        findInIndex(waitingIndex,processID,timestamp,best);
+        if(indexGrowing)
+            findInIndex(growingIndex,processID,timestamp,best);
+        return best;
+    }
+    
+    // Ends the job's stay in its current importance bucket, for history queries
+    void closeBucketStay(IdT jobID,TimeT timestamp)
+    {
+        PhaseTimer historyTimer(profiler,PHASE_HISTORY);
+        JobT &job = jobList[jobID];
+        if(job.bucketExit == NOT_EXITED)
+        {
+            // Still in the bucket it was submitted to
+            job.bucketExit = timestamp;
+            if(job.historyPos != numeric_limits<IdT>::max())
+                qJobList[job.importance].markExited(job.historyPos,timestamp);
+            return;
+        }
+        typename unordered_map<IdT,OpenStay>::iterator it = currentStay.find(jobID);
+        BucketStay &stay = movedStays[it->second.index];
+        stay.until = timestamp;
+        stayGroups[stayGroup(stay)].setUntil(it->second.groupPos,timestamp);
+        if(it->second.topPos >= 0)
+            topStays.setUntil(it->second.topPos,timestamp);
+        currentStay.erase(it);
+    }
+    
+    // Removes a waiting job from the queue at the last seen timestamp, as if it left the queue then.
+    void cancelJob(ll processID,TimeT timestamp)
+    {
+        PhaseTimer indexTimer(profiler,PHASE_INDEX);
+        IdT jobID = findWaitingJob(processID,timestamp);
+        if(jobID == NO_JOB)
+            return;
+        removeFromWaitingIndex(jobID);
+        indexTimer.stop();
+        
+        JobT &job = jobList[jobID];
+        unqueueJob(jobID);
+        job.qExit = prevTimestamp;
+        closeBucketStay(jobID,prevTimestamp);
+        startTimeRoot = deleteCustom(startTimeRoot,job.timestamp);
+        updateMaxMins(prevTimestamp);
+    }
+    
+    // Moves a waiting job to another importance bucket
+    void moveJob(IdT jobID,int importance)
+    {
+        JobT &job = jobList[jobID];
+        if(job.importance == importance)
+            return;
+        unqueueJob(jobID);
+        job.importance = importance;
+        queueJob(jobID);
+    }
+    
+    // Adds a waiting job to its importance queue, or to its origin's queue in fair-share mode
+    void queueJob(IdT jobID)
+    {
+        const JobT &job = jobList[jobID];
+        if(!fairShare)
+        {
+            jobHeap[job.importance].insert(jobID);
+            return;
+        }
+        FairShareOrigin &origin = fairOrigins[job.origin];
+        origin.queue.insert(jobID);
+        if(!origin.inRound)
+        {
+            origin.inRound = true;
+            origin.deficit = origin.weight;
+            fairRound.push_back(job.origin);
+        }
+    }
+    
+    void unqueueJob(IdT jobID)
+    {
+        const JobT &job = jobList[jobID];
+        if(fairShare)
+            fairOrigins[job.origin].queue.remove(jobID);
+        else jobHeap[job.importance].remove(jobID);
+    }
+    
+    // Interns originSystem and makes sure it has a fair-share queue
+    unsigned int getFairOrigin(const string &originSystem)
+    {
+        unsigned int index = origins.intern(originSystem);
+        while(fairOrigins.size() <= index)
+        {
+            FairShareOrigin origin;
+            origin.queue.setCompare(JobPriority(this));
+            origin.weight = 1;
+            origin.deficit = 0;
+            origin.inRound = false;
+            fairOrigins.push_back(origin);
+        }
+        return index;
+    }
+    
+    void printJob(IdT jobID,unsigned short importance)
+    {
+        JobT &job = jobList[jobID];
+        job.printDescription(epoch,importance,origins[job.origin]);
+    }
+    
+    // Next job by deficit round robin, NO_JOB if nothing is waiting. O(logN) for the job, amortized O(1) for the origin.
+    IdT extractFairShare()
+    {
+        while(fairRound.size())
+        {
+            unsigned int index = fairRound.front();
+            FairShareOrigin &origin = fairOrigins[index];
+            if(origin.queue.size() == 0)
+            {
+                // Emptied by cancel or reprioritize while waiting for its turn, its share is not kept
+                origin.inRound = false;
+                fairRound.pop_front();
+                continue;
+            }
+            IdT jobID = origin.queue.extract();
+            if(--origin.deficit == 0 || origin.queue.size() == 0)
+            {
+                fairRound.pop_front();
+                origin.inRound = origin.queue.size() > 0;
+                origin.deficit = origin.weight;
+                if(origin.inRound)
+                    fairRound.push_back(index);
+            }
+            return jobID;
+        }
+        return NO_JOB;
+    }
+    
+    // Number of busy CPUs at a past timestamp and when the next of them becomes free
+    void printCPUsAt(ll timestamp,TimeT relTimestamp,bool beforeEpoch)
+    {
+        typename CPUHistory<TimeT,IdT>::VersionNode *root = NULL;
+        bool known = cpuHistoryCap > 0 && cpuHistory.findVersion(relTimestamp,root);
+        // Before the epoch nothing ran, which is known as long as the first version is kept
+        if(beforeEpoch)
+            known = cpuHistoryCap > 0 && !cpuHistory.dropped;
+        if(cpuHistoryCap == 0)
+        {
+            cout<<"cpuquery "<<timestamp<<" disabled"<<endl;
+            return;
+        }
+        if(!known)
+        {
+            cout<<"cpuquery "<<timestamp<<" expired"<<endl;
+            return;
+        }
+        IdT busy = 0;
+        TimeT nextFree = 0;
+        if(!beforeEpoch)
+            cpuHistory.busyAt(root,relTimestamp,busy,nextFree);
+        if(busy == 0)
+            cout<<"cpuquery "<<timestamp<<" 0 none"<<endl;
+        else cout<<"cpuquery "<<timestamp<<" "<<busy<<" "<<(nextFree + epoch)<<endl;
+    }
+    
+    // Hands a job over to a free CPU at timestamp
+    void startJob(IdT jobID,TimeT timestamp)
+    {
+        // The job was checked against its submit time, it may have waited long enough to end past the range
+        if(jobList[jobID].duration >= NOT_EXITED - timestamp)
+            reportOverflow("job end time",timestamp + epoch + jobList[jobID].duration);
+        PhaseTimer outputTimer(profiler,PHASE_OUTPUT);
+        printJob(jobID,jobList[jobID].importance);
+        outputTimer.stop();
+        PhaseTimer cpuTimer(profiler,PHASE_CPU_TREE);
+        cpuTreeRoot = deleteCPUNode(cpuTreeRoot,timestamp);
+        cpuTreeRoot = insertCPUNode(cpuTreeRoot,(TimeT)(timestamp + jobList[jobID].duration));
+        if(cpuHistoryCap > 0)
+            cpuHistory.startJob(timestamp + jobList[jobID].duration);
+        cpuTimer.stop();
+        jobList[jobID].qExit = timestamp;
+        closeBucketStay(jobID,timestamp);
+        PhaseTimer maxMinsTimer(profiler,PHASE_MAXMINS);
+        startTimeRoot = deleteCustom(startTimeRoot,jobList[jobID].timestamp);
+        maxMinsTimer.stop();
+        PhaseTimer indexTimer(profiler,PHASE_INDEX);
+        removeFromWaitingIndex(jobID);
+    }
+    
+    // Records in history that the job has its current importance from timestamp on
+    void openBucketStay(IdT jobID,TimeT timestamp)
+    {
+        PhaseTimer historyTimer(profiler,PHASE_HISTORY);
+        const JobT &job = jobList[jobID];
+        BucketStay stay;
+        stay.timestamp = job.timestamp;
+        stay.duration = job.duration;
+        stay.jobID = jobID;
+        stay.from = timestamp;
+        stay.until = NOT_EXITED;
+        stay.importance = job.importance;
+        stay.aging = ageInterval > 0;
+        // A job moved twice at the same timestamp leaves an empty stay behind, which is never open at any time
+        movedStays.push_back(stay);
+        OpenStay &open = currentStay[jobID];
+        open.index = movedStays.size() - 1;
+        open.groupPos = stayGroups[stayGroup(stay)].add(timestamp,NOT_EXITED,open.index);
+        open.topPos = -1;
+        if(stay.aging && stay.importance == LEVELS - 1)
+            open.topPos = topStays.add(timestamp,NOT_EXITED,open.index);
+    }
+    
+    // Moves a waiting job to the given importance at the last seen timestamp, its aging clock restarts from there
+    void reprioritizeJob(ll processID,TimeT timestamp,ll importance)
+    {
+        if(importance < 1 || importance >= LEVELS)
+            return;
+        PhaseTimer indexTimer(profiler,PHASE_INDEX);
+        IdT jobID = findWaitingJob(processID,timestamp);
+        indexTimer.stop();
+        if(jobID == NO_JOB)
+            return;
+        closeBucketStay(jobID,prevTimestamp);
+        moveJob(jobID,importance);
+        openBucketStay(jobID,prevTimestamp);
+        scheduleAging(jobID,prevTimestamp);
+    }
+    
+    // Schedules the next promotion of a job one ageInterval after timestamp
+    void scheduleAging(IdT jobID,TimeT timestamp)
+    {
+        if(ageInterval == 0)
+            return;
+        while(nextAging.size() <= jobID)
+            nextAging.push_back(NOT_EXITED);
+        nextAging[jobID] = NOT_EXITED;
+        if(jobList[jobID].importance >= LEVELS - 1 || timestamp >= NOT_EXITED - ageInterval)
+            return;
+        nextAging[jobID] = timestamp + ageInterval;
+        agingQueue.push(make_pair(nextAging[jobID],jobID));
+    }
+    
+    // Promotes every waiting job whose next promotion is due at or before timestamp.
+    // Only jobs that are due are touched, but each promotion is an O(logN) move between buckets, so the total is
+    // O(logN) per job per interval waited (see the aging notes in the header).
+    void ageWaitingJobs(TimeT timestamp)
+    {
+        while(agingQueue.size() && agingQueue.top().first <= timestamp)
+        {
+            TimeT due = agingQueue.top().first;
+            IdT jobID = agingQueue.top().second;
+            agingQueue.pop();
+            if(jobList[jobID].qExit != NOT_EXITED || nextAging[jobID] != due)
+                continue;
+            // The first promotion starts an aging stay, which accounts for the later ones
+            if(jobList[jobID].bucketExit == NOT_EXITED)
+            {
+                closeBucketStay(jobID,due);
+                moveJob(jobID,jobList[jobID].importance + 1);
+                openBucketStay(jobID,due);
+            }
+            else
+            {
+                moveJob(jobID,jobList[jobID].importance + 1);
+                if(jobList[jobID].importance == LEVELS - 1)
+                {
+                    OpenStay &open = currentStay[jobID];
+                    open.topPos = topStays.add(due,NOT_EXITED,open.index);
+                }
+            }
+            scheduleAging(jobID,due);
+        }
+        agedUntil = timestamp;
+    }
+    
+    // Records a query to be answered by answerOfflineQueries, output goes to a buffer until then
+    void deferQuery(TimeT timestamp,const string &operation)
+    {
+        OfflineQuery query;
+        query.timestamp = timestamp;
+        query.K = 0;
+        if(containsAlphabet(operation))
+            query.origin = operation;
+        else query.K = convertStringToLL(operation);
+        query.outputOffset = cout.tellp();
+        offlineQueries.push_back(query);
+    }
+    
+    void addSegment(vector<HistorySegment> &segments,TimeT start,TimeT end,IdT jobID,int importance)
+    {
+        if(start >= end)
+            return;
+        HistorySegment segment;
+        segment.start = start;
+        segment.end = end;
+        segment.jobID = jobID;
+        segment.importance = importance;
+        segments.push_back(segment);
+    }
+    
+    // Every stay of every job in an importance bucket, aging stays are split at each promotion
+    void collectHistorySegments(vector<HistorySegment> &segments)
+    {
+        IdT jobIDs[HISTORY_BLOCK_SIZE];
+        TimeT timestamps[HISTORY_BLOCK_SIZE];
+        for(int importance=1; importance<LEVELS; importance++)
+        {
+            Bucket &bucket = qJobList[importance];
+            for(ll start=0; start<bucket.size(); start+=HISTORY_BLOCK_SIZE)
+            {
+                ll count = bucket.decodeBlock(start,jobIDs,timestamps);
+                for(ll k=0; k<count; k++)
+                    addSegment(segments,timestamps[k],jobList[jobIDs[k]].bucketExit,jobIDs[k],importance);
+            }
+        }
+        for(ll i=0; i<movedStays.size(); i++)
+        {
+            const BucketStay *it = &movedStays[i];
+            TimeT from = it->from;
+            int importance = it->importance;
+            while(from < it->until)
+            {
+                // Only promotions that were applied split the stay, as in importanceAt
+                TimeT next = it->until;
+                if(it->aging && importance < LEVELS - 1 && ageInterval < NOT_EXITED - from && from + ageInterval <= agedUntil && from + ageInterval < next)
+                    next = from + ageInterval;
+                addSegment(segments,from,next,it->jobID,importance);
+                from = next;
+                importance++;
+            }
+        }
+    }
+    
+    // Answers all recorded queries in increasing order of time. Jobs enter and leave a set of waiting jobs
+    // per importance bucket (and per origin) as the sweep passes the ends of their history segments, so
+    // every query is answered from the live sets in O(output) after O((N + Q)logN) of updates in total.
+    void answerOfflineQueries()
+    {
+        finishPendingFlushes();
+        if(totalSize > 0)
+            emptyOutAllDurationHeaps();
+        
+        vector<HistorySegment> segments;
+        collectHistorySegments(segments);
+        vector< pair<TimeT,ll> > enters,leaves,queries;
+        for(ll i=0; i<segments.size(); i++)
+        {
+            enters.push_back(make_pair(segments[i].start,i));
+            if(segments[i].end != NOT_EXITED)
+                leaves.push_back(make_pair(segments[i].end,i));
+        }
+        for(ll i=0; i<offlineQueries.size(); i++)
+            queries.push_back(make_pair(offlineQueries[i].timestamp,i));
+        sort(enters.begin(),enters.end());
+        sort(leaves.begin(),leaves.end());
+        sort(queries.begin(),queries.end());
+        
+        set<LiveJob> live[LEVELS];
+        map< unsigned int,set<LiveJob> > liveByOrigin;
+        ll nextEnter = 0,nextLeave = 0;
+        for(ll q=0; q<queries.size(); q++)
+        {
+            TimeT timestamp = queries[q].first;
+            // A job that leaves one bucket and enters another at the same time is removed first
+            while(true)
+            {
+                bool canLeave = nextLeave < leaves.size() && leaves[nextLeave].first <= timestamp;
+                bool canEnter = nextEnter < enters.size() && enters[nextEnter].first <= timestamp;
+                if(!canLeave && !canEnter)
+                    break;
+                bool entering = canEnter && (!canLeave || enters[nextEnter].first < leaves[nextLeave].first);
+                const HistorySegment &segment = segments[entering ? enters[nextEnter++].second : leaves[nextLeave++].second];
+                const JobT &job = jobList[segment.jobID];
+                LiveJob entry;
+                entry.importance = segment.importance;
+                entry.timestamp = job.timestamp;
+                entry.duration = job.duration;
+                entry.jobID = segment.jobID;
+                if(entering)
+                {
+                    live[entry.importance].insert(entry);
+                    liveByOrigin[job.origin].insert(entry);
+                }
+                else
+                {
+                    live[entry.importance].erase(entry);
+                    liveByOrigin[job.origin].erase(entry);
+                }
+            }
+            
+            OfflineQuery &query = offlineQueries[queries[q].second];
+            if(query.origin.size())
+            {
+                set<LiveJob> &jobs = liveByOrigin[origins.find(query.origin)];
+                for(typename set<LiveJob>::iterator it=jobs.begin(); it != jobs.end(); ++it)
+                    query.result.push_back(make_pair(it->jobID,it->importance));
+                continue;
+            }
+            for(int importance=LEVELS-1; importance>0 && query.result.size()<query.K; importance--)
+                for(typename set<LiveJob>::iterator it=live[importance].begin(); it != live[importance].end() && query.result.size()<query.K; ++it)
+                    query.result.push_back(make_pair(it->jobID,it->importance));
+        }
+    }
+    
+    // Writes the buffered simulation output with the query results put back in input order
+    void printOfflineOutput(const string &simulationOutput)
+    {
+        ll written = 0;
+        for(ll i=0; i<offlineQueries.size(); i++)
+        {
+            OfflineQuery &query = offlineQueries[i];
+            cout.write(simulationOutput.data() + written,query.outputOffset - written);
+            written = query.outputOffset;
+            for(ll k=0; k<query.result.size(); k++)
+                printJob(query.result[k].first,query.result[k].second);
+        }
+        cout.write(simulationOutput.data() + written,simulationOutput.size() - written);
+        cout.flush();
+    }
+    
+    // 'job': a new job comes in at timestamp
+    void addJob(ll timestamp,ll processID,const string &originSystem,const string &instruction,ll importance,ll duration)
+    {
+        TimeT relTimestamp = toRelativeTime(timestamp);
+        if(duration >= NOT_EXITED - relTimestamp || duration > numeric_limits<DurT>::max())
+            reportOverflow("duration",duration);
+        if(ID == numeric_limits<IdT>::max())
+            reportOverflow("job count",(ll)ID + 1);
+        if(importance < 1 || importance >= LEVELS)
+            reportOutOfRange("importance",importance,1,LEVELS - 1);
+        
+        if(ageInterval > 0)
+        {
+            PhaseTimer timer(profiler,PHASE_AGING);
+            ageWaitingJobs(relTimestamp);
+        }
+        
+        PhaseTimer flushTimer(profiler,PHASE_DURATION_HEAPS);
+        if(relTimestamp > prevTimestamp && totalSize > 0)
+            closeAllDurationHeaps();
+        flushTimer.stop();
+        if(jitterBudget > 0)
+            doDeferredWork(jitterBudget);
+        
+        prevTimestamp = relTimestamp;
+        
+        PhaseTimer storageTimer(profiler,PHASE_STORAGE);
+        unsigned int origin = fairShare ? getFairOrigin(originSystem) : origins.intern(originSystem);
+        jobList.push_back(JobT(processID,relTimestamp,origin,instructions.add(instruction),importance,duration,NOT_EXITED));
+        heapPositions.push_back(0);
+        storageTimer.stop();
+        PhaseTimer indexTimer(profiler,PHASE_INDEX);
+        addToWaitingIndex(ID);
+        indexTimer.stop();
+        PhaseTimer queueTimer(profiler,PHASE_HEAP_INSERT);
+        queueJob(ID);
+        queueTimer.stop();
+        
+        PhaseTimer durationTimer(profiler,PHASE_DURATION_HEAPS);
+        // Duration heap is empty
+        if(durationHeapSize[importance] == 0)
+        {
+            insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
+            prevTimestamps[importance] = relTimestamp;
+        }
+        // Alread some entries are present
+        else
+        {
+            if(prevTimestamps[importance] == relTimestamp)
+                insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
+            else
+            {
+                prevTimestamps[importance] = relTimestamp;
+                closeDurationHeap(importance);
+                insertIntoDurationHeap(ID,durationHeaps[importance],durationHeapSize[importance]);
+            }
+        }
+        durationTimer.stop();
+        
+        PhaseTimer agingTimer(profiler,PHASE_AGING);
+        scheduleAging(ID,relTimestamp);
+        agingTimer.stop();
+        ID++;
+        
+        PhaseTimer maxMinsTimer(profiler,PHASE_MAXMINS);
+        startTimeRoot = insertCPUNode(startTimeRoot,relTimestamp);
+        
+        if(MaxMins.size() == 0)
+            MaxMins.push_back(MaxMinNode<TimeT>(relTimestamp,relTimestamp,relTimestamp));
+        else if(MaxMins[MaxMins.size()-1].timestamp == relTimestamp)
+            MaxMins[MaxMins.size()-1].updateValues(relTimestamp);
+         else
+        {
+            TimeT Min = getMinimum(startTimeRoot);
+            TimeT Max = getMaximum(startTimeRoot);
+            MaxMins.push_back(MaxMinNode<TimeT>(Min,Max,relTimestamp));
+         }
+    }
+    
+    // 'assign': starts up to K waiting jobs on the CPUs free at timestamp
+    void assignJobs(ll timestamp,ll K)
+    {
+        TimeT relTimestamp = toRelativeTime(timestamp);
+        
+        if(ageInterval > 0)
+        {
+            PhaseTimer timer(profiler,PHASE_AGING);
+            ageWaitingJobs(relTimestamp);
+        }
+        
+        // No jobs with multiple timestamps less than this will be seen so flush the durationHeaps
+        PhaseTimer flushTimer(profiler,PHASE_DURATION_HEAPS);
+        if(totalSize > 0)
+            closeAllDurationHeaps();
+        flushTimer.stop();
+        if(jitterBudget > 0)
+            doDeferredWork(jitterBudget);
+        
+        // Get number of jobs to be assigned
+        PhaseTimer cpuTimer(profiler,PHASE_CPU_TREE);
+        ll freeCPU = getValuesLessThanEqualTo(cpuTreeRoot,relTimestamp);
+        cpuTimer.stop();
+        
+        prevTimestamp = relTimestamp;
+        
+        
+        // Scan from highest to lowest importance buckets to get the jobs to be assigned
+        K = min(freeCPU,K);
+        ll selected = 0;
+        ll importance = LEVELS - 1;
+        for(; fairShare && selected < K; selected++)
+        {
+            PhaseTimer extractTimer(profiler,PHASE_QUEUE_EXTRACT);
+            IdT nextJobID = extractFairShare();
+            extractTimer.stop();
+            if(nextJobID == NO_JOB)
+                break;
+            startJob(nextJobID,relTimestamp);
+        }
+        // Keep assigning till desired number is met
+        while(!fairShare && selected < K && importance != 0)
+        {
+            ll choose = K - selected;
+            ll newJobsToSchedule = min(choose,(ll)jobHeap[importance].size());
+            if(newJobsToSchedule == 0)
+            {
+                importance--;
+                continue;
+            }
+            
+            PhaseTimer extractTimer(profiler,PHASE_QUEUE_EXTRACT);
+            assigned.clear();
+            jobHeap[importance].extractK(newJobsToSchedule,assigned);
+            extractTimer.stop();
+            for(ll i=0; i<newJobsToSchedule; ++i)
+                startJob(assigned[i],relTimestamp);
+            selected += newJobsToSchedule;
+            importance--;
+        }
+        if(cpuHistoryCap > 0 && selected > 0)
+        {
+            PhaseTimer timer(profiler,PHASE_CPU_TREE);
+            cpuHistory.commit(relTimestamp);
+        }
+        
+        PhaseTimer maxMinsTimer(profiler,PHASE_MAXMINS);
+        updateMaxMins(relTimestamp);
+        maxMinsTimer.stop();
+        
+        if(profiler)
+        {
+            profiler->current.k = K;
+            profiler->current.jobs = selected;
+            profiler->current.buckets = fairShare ? 0 : LEVELS - 1 - importance;
+        }
+    }
+    
+    void processCommand(const char *lineInput)
+    {
+        string operation;
+        ll noOfCPU;
+        ll processID,timestamp,duration,importance;
+        string originSystem,instruction;
+        ll K;
+        
+        PhaseTimer parseTimer(profiler,PHASE_PARSE);
+        stringstream ss(lineInput);
+        ss>>operation;
+        if(profiler)
+            profiler->current.operation = operation;
+        if(operation == "cpus")
+        {
+            ss>>noOfCPU;
+            parseTimer.stop();
+            cpuTreeRoot = createBST<Node>(noOfCPU); // Create root node of CPU BST Tree
+            if(cpuHistoryCap > 0)
+                cpuHistory.reset(noOfCPU,cpuHistoryCap);
+            // Nothing indexed by job has to grow (and move) while jobs come in
+            jobList.reserve(expectedJobs);
+            heapPositions.reserve(expectedJobs);
+            waitingIndex.reserve(expectedJobs);
+            if(ageInterval > 0)
+                nextAging.reserve(expectedJobs);
+        }   
+        else if(operation == "job")
+        {
+            ss>>timestamp;
+            ss>>processID;
+            ss>>originSystem;
+            ss>>instruction;
+            ss>>importance;
+            ss>>duration;
+            parseTimer.stop();
+            addJob(timestamp,processID,originSystem,instruction,importance,duration);
+        }
+        else if(operation == "assign")
+        {
+            ss>>timestamp;
+            ss>>K;
+            parseTimer.stop();
+            assignJobs(timestamp,K);
+        }
+        else if(operation == "weight")
+        {
+            ss>>originSystem;
+            ss>>K;
+            parseTimer.stop();
+            
+            // Jobs an origin gets per turn in fair-share mode, takes effect from its next turn
+            if(fairShare && K > 0)
+                fairOrigins[getFairOrigin(originSystem)].weight = K;
+        }
+        else if(operation == "reprioritize")
+        {
+            ss>>timestamp;
+            ss>>processID;
+            ss>>importance;
+            parseTimer.stop();
+            
+            if(!epochSet || timestamp < epoch || timestamp - epoch >= NOT_EXITED)
+                return;
+            reprioritizeJob(processID,timestamp - epoch,importance);
+        }
+        else if(operation == "cancel")
+        {
+            ss>>timestamp;
+            ss>>processID;
+            parseTimer.stop();
+            
+            if(!epochSet || timestamp < epoch || timestamp - epoch >= NOT_EXITED)
+                return;
+            cancelJob(processID,timestamp - epoch);
+        }
+        else if(operation == "cpuquery")
+        {
+            ss>>timestamp;
+            parseTimer.stop();
+            
+            // Before the first job every CPU was free
+            if(!epochSet || timestamp < epoch)
+                printCPUsAt(timestamp,0,true);
+            else printCPUsAt(timestamp,(timestamp - epoch >= NOT_EXITED) ? (TimeT)(NOT_EXITED - 1) : (TimeT)(timestamp - epoch),false);
+        }
+        else if(operation == "query")
+        {
+            ss>>timestamp;
+            ss>>operation;
+            parseTimer.stop();
+            
+            // Nothing was waiting before the first job
+            if(!epochSet || timestamp < epoch || MaxMins.size() == 0)
+                return;
+            // Queries past the representable range see the latest state
+            TimeT relTimestamp = (timestamp - epoch >= NOT_EXITED) ? (TimeT)(NOT_EXITED - 1) : (TimeT)(timestamp - epoch);
+            if(relTimestamp < MaxMins[0].timestamp)
+                return;
+            
+            if(offline)
+            {
+                deferQuery(relTimestamp,operation);
+                return;
+            }
+            
+            // If timestamp is greater than earlier seen timestamp then flush out the durationHeaps
+            PhaseTimer flushTimer(profiler,PHASE_DURATION_HEAPS);
+            finishPendingFlushes();
+            if(relTimestamp >= prevTimestamp && totalSize > 0)
+                emptyOutAllDurationHeaps();
+            flushTimer.stop();
+            
+            // Checks if string contains alphabet to distinguish the two query types
+            PhaseTimer scanTimer(profiler,PHASE_HISTORY_SCAN);
+            if(!containsAlphabet(operation))
+            {
+                if(profiler)
+                    profiler->current.k = convertStringToLL(operation);
+                printHistory_TOPK(relTimestamp,convertStringToLL(operation));
+            }
+            else
+                printHistory_Origin(relTimestamp,operation);
+        }
+    }
+};
+
+template<typename IdT,typename TimeT,typename DurT,int LEVELS,template<typename,class> class QueueT>
+const TimeT Scheduler<IdT,TimeT,DurT,LEVELS,QueueT>::NOT_EXITED;
+template<typename IdT,typename TimeT,typename DurT,int LEVELS,template<typename,class> class QueueT>
+const IdT Scheduler<IdT,TimeT,DurT,LEVELS,QueueT>::NO_JOB;
+template<typename IdT,typename TimeT,typename DurT,int LEVELS,template<typename,class> class QueueT>
+const int Scheduler<IdT,TimeT,DurT,LEVELS,QueueT>::HISTORY_BLOCK_SIZE;
+
+// Startup options, set from the command line
+struct SchedulerOptions
+{
+    int width; // 32 or 64 bit keys
+    string heap; // job queue backend
+    ll ageInterval; // 0 disables aging
+    bool offline; // answer queries after the whole trace has been read
+    ll expectedJobs; // storage for this many jobs is allocated up front
+    ll jitterBudget; // low-jitter mode: deferred work per command, 0 is off
+    bool latencyReport; // print per-command latency percentiles on stderr
+    string latencyBaseline; // percentiles to compare against, recorded there if the file does not exist
+    ll latencyTolerance; // percent above the baseline reported as a regression
+    bool fairShare; // assign across origins by deficit round robin
+    ll cpuHistoryCap; // bytes kept for past CPU states, 0 is off
+    ll submitBench; // benchmark submission from 1, 2, 4 .. this many producer threads instead of reading stdin
+    string profilePath; // write a profile of the run to <profilePath>.csv and .folded, empty is off
+    ll profileTop; // slowest commands listed in the profile
+    SchedulerOptions()
+    {
+        profileTop = 20;
+        submitBench = 0;
+        cpuHistoryCap = 0;
+        fairShare = false;
+        expectedJobs = 0;
+        jitterBudget = 0;
+        latencyReport = false;
+        latencyTolerance = 10;
+        width = 64;
+        heap = "binary";
+        ageInterval = 0;
+        offline = false;
+    }
+};
+
+// Percentiles of the time taken by each command, to compare runs with and without '--jitter-budget='.
+// With a baseline file they are checked against a recorded run, or recorded there if the file does not exist.
+// Returns false if p50, p99 or p99.9 is more than tolerance percent above the baseline.
+bool printLatencyReport(vector<double> &latencies,const string &baselinePath,ll tolerance)
+{
+    static const char *NAMES[4] = {"p50","p99","p99.9","max"};
+    sort(latencies.begin(),latencies.end());
+    ll n = latencies.size();
+    double percentiles[4] = {latencies[n/2],latencies[n*99/100],latencies[n*999/1000],latencies[n-1]};
+    fprintf(stderr,"commands %llu  p50 %.1fus  p99 %.1fus  p99.9 %.1fus  max %.1fus\n",n,
+        percentiles[0],percentiles[1],percentiles[2],percentiles[3]);
+    if(baselinePath.empty())
+        return true;
+    
+    FILE *in = fopen(baselinePath.c_str(),"r");
+    if(in == NULL)
+    {
+        FILE *out = fopen(baselinePath.c_str(),"w");
+        if(out == NULL)
+        {
+            fprintf(stderr,"cannot write the latency baseline to %s\n",baselinePath.c_str());
+            return false;
+        }
+        for(int i=0; i<4; i++)
+            fprintf(out,"%s %.3f\n",NAMES[i],percentiles[i]);
+        fclose(out);
+        fprintf(stderr,"latency baseline recorded in %s\n",baselinePath.c_str());
+        return true;
+    }
+    double baseline[4];
+    char name[16];
+    for(int i=0; i<4; i++)
+    {
+        if(fscanf(in,"%15s %lf",name,&baseline[i]) != 2 || strcmp(name,NAMES[i]) != 0)
+        {
+            fprintf(stderr,"%s is not a latency baseline\n",baselinePath.c_str());
+            fclose(in);
+            return false;
+        }
+    }
+    fclose(in);
+    
+    // The max is a single command and too noisy to gate on, it is only shown
+    bool passed = true;
+    for(int i=0; i<4; i++)
+    {
+        bool regressed = i < 3 && percentiles[i] > baseline[i]*(1 + tolerance/100.0);
+        fprintf(stderr,"%-5s %9.1fus  baseline %9.1fus  %+6.1f%%%s\n",NAMES[i],percentiles[i],baseline[i],
+            baseline[i] > 0 ? (percentiles[i]/baseline[i] - 1)*100 : 0.0,regressed ? "  REGRESSION" : "");
+        passed = passed && !regressed;
+    }
+    return passed;
+}
+
+template<class SchedulerT>
+SchedulerT *createScheduler(const SchedulerOptions &options)
+{
+    SchedulerT *scheduler = new SchedulerT();
+    scheduler->ageInterval = options.ageInterval;
+    scheduler->offline = options.offline;
+    scheduler->expectedJobs = options.expectedJobs;
+    scheduler->fairShare = options.fairShare;
+    scheduler->cpuHistoryCap = options.cpuHistoryCap;
+    // Every command adds at most one entry to each kind of deferred work, so two per command always catch up
+    scheduler->jitterBudget = options.jitterBudget ? max(options.jitterBudget,2ULL) : 0;
+    return scheduler;
+}
+
+// Producer thread of '--submit-bench': takes every producers-th job of a synthetic trace, four jobs per time unit
+void produceBenchJobs(SubmissionRing<SubmittedJob> *ring,ll index,ll producers,ll jobs)
+{
+    SubmittedJob job;
+    job.originSystem = "origin" + to_string(index);
+    job.instruction = "bench";
+    ll seed = index + 1;
+    for(ll i=index; i<jobs; i+=producers)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        job.timestamp = i / 4;
+        job.processID = i;
+        job.importance = 1 + (seed >> 33) % 100;
+        job.duration = 1 + (seed >> 45) % 64;
+        ring->push(job);
+    }
+    ring->close();
+}
+
+// '--submit-bench=<P>': sends the same trace through 1, 2, 4 .. P producer threads and prints the jobs per second
+// on stderr, once with the consumer only reading the merged stream and once with it feeding the scheduler
+// (an 'assign' of 16 after every 16 jobs on 256 CPUs)
+template<class SchedulerT>
+int runSubmitBenchmark(const SchedulerOptions &options)
+{
+    const ll JOBS = 1ULL << 21;
+    // The assigned jobs are not printed
+    streambuf *console = cout.rdbuf(NULL);
+    for(ll producers = 1; producers <= options.submitBench; producers *= 2)
+    {
+        for(int feed = 0; feed < 2; feed++)
+        {
+            SchedulerT *scheduler = NULL;
+            if(feed)
+            {
+                scheduler = createScheduler<SchedulerT>(options);
+                scheduler->processCommand("cpus 256");
+            }
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            JobSubmission submission(producers);
+            vector<thread> threads;
+            for(ll i=0; i<producers; i++)
+                threads.push_back(thread(produceBenchJobs,&submission.producer(i),i,producers,JOBS));
+            
+            SubmittedJob job;
+            ll count = 0,last = 0;
+            bool ordered = true;
+            while(submission.next(job))
+            {
+                ordered = ordered && job.timestamp >= last;
+                last = job.timestamp;
+                count++;
+                if(scheduler == NULL)
+                    continue;
+                scheduler->addJob(job.timestamp,job.processID,job.originSystem,job.instruction,job.importance,job.duration);
+                if(count % 16 == 0)
+                    scheduler->assignJobs(job.timestamp,16);
+            }
+            for(size_t i=0; i<threads.size(); i++)
+                threads[i].join();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            fprintf(stderr,"producers %llu  %-10s  %llu jobs  %.2f Mjobs/s%s\n",producers,feed ? "scheduler" : "queue only",
+                count,count / seconds / 1e6,ordered ? "" : "  OUT OF ORDER");
+            delete scheduler;
+        }
+    }
+    cout.rdbuf(console);
+    cout.clear();
+    return 0;
+}
+
+template<class SchedulerT>
+int runScheduler(const SchedulerOptions &options,const char *firstLine)
+{
+    if(options.submitBench > 0)
+        return runSubmitBenchmark<SchedulerT>(options);
+    char lineInput[5000];
+    SchedulerT *scheduler = createScheduler<SchedulerT>(options);
+    
+    // In offline mode the output of the simulation is held back so the query results can be put in between
+    stringstream simulationOutput;
+    streambuf *console = NULL;
+    if(options.offline)
+        console = cout.rdbuf(simulationOutput.rdbuf());
+    
+    CommandProfiler *profiler = NULL;
+    if(options.profilePath.size())
+        profiler = scheduler->profiler = new CommandProfiler(options.profileTop);
+    
+    ll line = 0;
+    if(firstLine != NULL)
+    {
+        line++;
+        if(profiler)
+            profiler->beginCommand(line,firstLine);
+        scheduler->processCommand(firstLine);
+        if(profiler)
+            profiler->endCommand();
+    }
+    vector<double> latencies;
+    while(fgets(lineInput,sizeof(lineInput),stdin))
+    {
+        line++;
+        if(profiler)
+            profiler->beginCommand(line,lineInput);
+        if(!options.latencyReport)
+            scheduler->processCommand(lineInput);
+        else
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            scheduler->processCommand(lineInput);
+            latencies.push_back(chrono::duration<double,micro>(chrono::steady_clock::now() - start).count());
+        }
+        if(profiler)
+            profiler->endCommand();
+    }
+    bool latencyPassed = true;
+    if(latencies.size())
+        latencyPassed = printLatencyReport(latencies,options.latencyBaseline,options.latencyTolerance);
+    
+    if(options.offline)
+    {
+        cout.rdbuf(console);
+        // The deferred queries are answered in one sweep, which the profile shows as a command of its own
+        if(profiler)
+        {
+            profiler->beginCommand(0,"");
+            profiler->current.operation = "offline_answer";
+        }
+        PhaseTimer scanTimer(profiler,PHASE_HISTORY_SCAN);
+        scheduler->answerOfflineQueries();
+        scanTimer.stop();
+        if(profiler)
+            profiler->endCommand();
+        scheduler->printOfflineOutput(simulationOutput.str());
+    }
+    if(profiler && !profiler->writeReports(options.profilePath))
+        return 1;
+    return latencyPassed ? 0 : 1;
+}
+
+
+// Picks the job queue backend for the given key widths
+template<typename IdT,typename TimeT,typename DurT>
+int runWithQueue(const SchedulerOptions &options,const char *firstLine)
+{
+    if(options.heap == "4ary")
+        return runScheduler< Scheduler<IdT,TimeT,DurT,101,FourAryJobHeap> >(options,firstLine);
+    if(options.heap == "pairing")
+        return runScheduler< Scheduler<IdT,TimeT,DurT,101,PairingJobHeap> >(options,firstLine);
+    if(options.heap == "monotone")
+        return runScheduler< Scheduler<IdT,TimeT,DurT,101,MonotoneJobQueue> >(options,firstLine);
+    return runScheduler< Scheduler<IdT,TimeT,DurT,101,BinaryJobHeap> >(options,firstLine);
+}
+
+
+int main(int argc,char *argv[]) {
+    /* Enter your code here. Read input from STDIN. Print output to STDOUT */   
+    char lineInput[5000];
+    SchedulerOptions options;
+    
+    // --width=32 selects the narrow scheduler, as does a third token on the cpus header ("cpus <M> 32")
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg.compare(0,8,"--width=") == 0)
+            options.width = atoi(arg.c_str() + 8);
+        else if(arg.compare(0,7,"--heap=") == 0)
+            options.heap = arg.substr(7);
+        else if(arg.compare(0,6,"--age=") == 0)
+            options.ageInterval = strtoull(arg.c_str() + 6,NULL,10);
+        else if(arg == "--offline")
+            options.offline = true;
+        else if(arg.compare(0,7,"--jobs=") == 0)
+            options.expectedJobs = strtoull(arg.c_str() + 7,NULL,10);
+        else if(arg.compare(0,16,"--jitter-budget=") == 0)
+            options.jitterBudget = strtoull(arg.c_str() + 16,NULL,10);
+        else if(arg == "--latency")
+            options.latencyReport = true;
+        else if(arg.compare(0,19,"--latency-baseline=") == 0)
+        {
+            options.latencyReport = true;
+            options.latencyBaseline = arg.substr(19);
+        }
+        else if(arg.compare(0,20,"--latency-tolerance=") == 0)
+            options.latencyTolerance = strtoull(arg.c_str() + 20,NULL,10);
+        else if(arg == "--fair-share")
+            options.fairShare = true;
+        else if(arg.compare(0,14,"--cpu-history=") == 0)
+            options.cpuHistoryCap = strtoull(arg.c_str() + 14,NULL,10) << 20;
+        else if(arg.compare(0,15,"--submit-bench=") == 0)
+            options.submitBench = strtoull(arg.c_str() + 15,NULL,10);
+        else if(arg.compare(0,10,"--profile=") == 0)
+            options.profilePath = arg.substr(10);
+        else if(arg.compare(0,14,"--profile-top=") == 0)
+            options.profileTop = strtoull(arg.c_str() + 14,NULL,10);
+    }
+    
+    if(options.width != 32 && options.width != 64)
+    {
+        fprintf(stderr,"--width must be 32 or 64\n");
+        return 1;
+    }
+    if(options.heap != "binary" && options.heap != "4ary" && options.heap != "pairing" && options.heap != "monotone")
+    {
+        fprintf(stderr,"--heap must be binary, 4ary, pairing or monotone\n");
+        return 1;
+    }
+    
+    // The monotone queue keeps a FIFO per importance, an origin's queue mixes importances
+    if(options.fairShare && options.heap == "monotone")
+    {
+        fprintf(stderr,"--fair-share cannot be used with --heap=monotone\n");
+        return 1;
+    }
+    
+    // The benchmark makes up its own trace
+    if(options.submitBench > 0)
+    {
+        if(options.width == 32)
+            return runWithQueue<uint32_t,uint32_t,uint32_t>(options,NULL);
+        return runWithQueue<ll,ll,ll>(options,NULL);
+    }
+    
+    if(!fgets(lineInput,sizeof(lineInput),stdin))
+        return 0;
+    
+    string operation;
+    ll noOfCPU;
+    int headerWidth;
+    stringstream ss(lineInput);
+    ss>>operation;
+    if(operation == "cpus" && ss>>noOfCPU && ss>>headerWidth)
+    {
+        if(headerWidth != 32 && headerWidth != 64)
+        {
+            fprintf(stderr,"the width on the cpus line must be 32 or 64\n");
+            return 1;
+        }
+        options.width = headerWidth;
+    }
+    
+    // 32-bit IDs, timestamps and durations for traces with fewer than 2^32 jobs spanning less than 2^32 time units
+    if(options.width == 32)
+        return runWithQueue<uint32_t,uint32_t,uint32_t>(options,lineInput);
+    return runWithQueue<ll,ll,ll>(options,lineInput);
+}
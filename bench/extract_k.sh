@@ -0,0 +1,34 @@
+#!/bin/sh
+# Compares the '--heap=' job queue backends end to end on two generated traces:
+#   shallow: 2M jobs over 100 importance levels, 'assign' K=1
+#   deep   : 1.5M jobs over 3 importance levels, 'assign' K<=60
+# Usage: bench/extract_k.sh [runs] [extra scheduler flags, e.g. --width=32]
+# Prints the best wall time of each backend over <runs> runs (3 by default), output discarded.
+set -e
+cd "$(dirname "$0")"
+RUNS=${1:-3}
+[ $# -gt 0 ] && shift
+WORK=${TMPDIR:-/tmp}/jobscheduler-bench
+mkdir -p "$WORK"
+
+${CXX:-g++} -std=c++17 -O2 -pthread -o "$WORK/JobScheduler" ../JobScheduler.cpp
+[ -f "$WORK/shallow.txt" ] || python3 gen_trace.py --jobs 2000000 --levels 100 --max-k 1 > "$WORK/shallow.txt"
+[ -f "$WORK/deep.txt" ] || python3 gen_trace.py --jobs 1500000 --levels 3 --max-k 60 > "$WORK/deep.txt"
+
+printf '%-10s %10s %10s %10s %10s\n' trace binary 4ary pairing monotone
+for trace in shallow deep; do
+    printf '%-10s' $trace
+    for heap in binary 4ary pairing monotone; do
+        best=
+        i=0
+        while [ $i -lt "$RUNS" ]; do
+            start=$(date +%s.%N)
+            "$WORK/JobScheduler" --heap=$heap "$@" < "$WORK/$trace.txt" > /dev/null
+            end=$(date +%s.%N)
+            best=$(echo "$start $end $best" | awk '{t = $2 - $1; if ($3 == "" || t < $3) print t; else print $3}')
+            i=$((i + 1))
+        done
+        printf ' %9.2fs' "$best"
+    done
+    printf '\n'
+done
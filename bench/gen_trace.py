@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+# Writes a synthetic scheduler trace on stdout: a 'cpus' line, then jobs with a few per
+# timestamp, an 'assign' after every few jobs and an occasional history 'query'.
+# The same arguments and seed always give the same trace.
+import argparse
+import random
+import sys
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--jobs', type=int, default=1000000)
+parser.add_argument('--levels', type=int, default=100, help='importance levels, 1..levels')
+parser.add_argument('--cpus', type=int, default=64)
+parser.add_argument('--max-k', type=int, default=1, help="K of each 'assign' is drawn from 1..max-k")
+parser.add_argument('--jobs-per-tick', type=int, default=4)
+parser.add_argument('--assign-every', type=int, default=4, help="jobs between 'assign' commands")
+parser.add_argument('--query-every', type=int, default=1000, help="jobs between 'query' commands")
+parser.add_argument('--seed', type=int, default=1)
+args = parser.parse_args()
+
+rand = random.Random(args.seed)
+write = sys.stdout.write
+write('cpus %d\n' % args.cpus)
+timestamp = 0
+for i in range(args.jobs):
+    if i % args.jobs_per_tick == 0:
+        timestamp += 1
+    write('job %d %d origin%d cmd%d %d %d\n' % (timestamp, i, rand.randrange(8), i % 97,
+                                               rand.randint(1, args.levels), rand.randint(1, 200)))
+    if i % args.assign_every == args.assign_every - 1:
+        write('assign %d %d\n' % (timestamp, rand.randint(1, args.max_k)))
+    if i % args.query_every == args.query_every - 1:
+        write('query %d %d\n' % (rand.randint(1, timestamp), rand.randint(1, 10)))
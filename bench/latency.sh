@@ -0,0 +1,24 @@
+#!/bin/sh
+# p99.9 regression check for the low-jitter mode on a bursty trace: 1M jobs arriving
+# 20000 at a time, an 'assign' of up to 64 after every 64 jobs, on 256 CPUs.
+# Usage: bench/latency.sh [baseline file] [extra scheduler flags, e.g. --jitter-budget=16]
+# The first run records the per-command latency percentiles in the baseline file
+# ($TMPDIR/jobscheduler-bench/latency-baseline by default), later runs compare against it
+# and exit with status 1 when p50, p99 or p99.9 is more than 10% above it
+# (--latency-tolerance=<percent> changes that). Delete the file to record a new baseline,
+# e.g. on another machine. The same trace without --jitter-budget is timed first for comparison.
+set -e
+cd "$(dirname "$0")"
+WORK=${TMPDIR:-/tmp}/jobscheduler-bench
+mkdir -p "$WORK"
+BASELINE=${1:-$WORK/latency-baseline}
+[ $# -gt 0 ] && shift
+
+${CXX:-g++} -std=c++17 -O2 -pthread -o "$WORK/JobScheduler" ../JobScheduler.cpp
+[ -f "$WORK/burst.txt" ] || python3 gen_trace.py --jobs 1000000 --levels 100 --cpus 256 --jobs-per-tick 20000 \
+    --assign-every 64 --max-k 64 > "$WORK/burst.txt"
+
+echo "without --jitter-budget:"
+"$WORK/JobScheduler" --latency < "$WORK/burst.txt" > /dev/null
+echo "with --jitter-budget=64:"
+"$WORK/JobScheduler" --jitter-budget=64 --latency-baseline="$BASELINE" "$@" < "$WORK/burst.txt" > /dev/null